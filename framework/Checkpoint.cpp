@@ -0,0 +1,154 @@
+#include "Checkpoint.h"
+#include <signal.h>
+#include <thread>
+#include <cstdio>
+
+// set by the signal handler, everything else happens in the watcher thread
+static volatile sig_atomic_t signalled = 0;
+static mutex handlerLock;
+static function<void()> interruptHandler;
+static bool watching = false;
+static bool handled = false;
+
+Checkpoint::Checkpoint( const string& _path, double _interval ) :
+path( _path ), interval( _interval ), lastWrite( 0 ), bound( -1e30 )
+{
+}
+
+void Checkpoint::save( const Solution& sol, double _bound, bool force )
+{
+	lock_guard<mutex> guard(lock);
+	bool better = sol.cost < last.cost - 1e-6 || last.routes.empty();
+	bool newBound = _bound > bound + 1e-6;
+	bound = max(bound, _bound);
+	if( !better && !newBound )
+		return;
+	if( !force && Tools::wallTime() - lastWrite < interval )
+		return;
+	// a better bound alone keeps the solution of the file
+	if( better )
+		last = sol;
+	if( write(last) )
+		lastWrite = Tools::wallTime();
+}
+
+void Checkpoint::reset()
+{
+	lock_guard<mutex> guard(lock);
+	last = Solution();
+	bound = -1e30;
+}
+
+bool Checkpoint::load( const string& path, Instance& instance, Solution& sol )
+{
+	ifstream is( path.c_str() );
+	if( !is.is_open() )
+	{
+		cerr << "Cannot open checkpoint " << path << endl;
+		return false;
+	}
+
+	sol.routes.clear();
+	string line;
+	while( getline( is, line ) )
+	{
+		stringstream ss( line );
+		string key;
+		ss >> key;
+		if( key != "tour" )
+			continue;
+		sol.routes.push_back(vector<int>());
+		int v;
+		while( ss >> v )
+		{
+			if( v <= 0 || v >= instance.n )
+			{
+				cerr << "Checkpoint " << path << " does not belong to this instance" << endl;
+				return false;
+			}
+			sol.routes.back().push_back(v);
+		}
+	}
+
+	sol.evaluate(instance);
+	if( !sol.isFeasible(instance) )
+	{
+		cerr << "Checkpoint " << path << " is not feasible for this instance" << endl;
+		return false;
+	}
+	return true;
+}
+
+void Checkpoint::onInterrupt( function<void()> handler )
+{
+	lock_guard<mutex> guard(handlerLock);
+	interruptHandler = handler;
+	if( watching )
+		return;
+	watching = true;
+	signal( SIGINT, &Checkpoint::handleSignal );
+	signal( SIGTERM, &Checkpoint::handleSignal );
+	thread(&Checkpoint::watch).detach();
+}
+
+bool Checkpoint::interrupted()
+{
+	return signalled != 0;
+}
+
+// ----- private methods -----------------------------------------------
+
+bool Checkpoint::write( const Solution& sol )
+{
+	// write to a temporary file first, rename() replaces the old one atomically
+	string tmp = path + ".tmp";
+	ofstream os( tmp.c_str() );
+	if( !os.is_open() )
+	{
+		cerr << "Cannot write checkpoint " << tmp << endl;
+		return false;
+	}
+	os << "objective " << sol.cost << "\n";
+	if( bound > -1e30 )
+		os << "bound " << bound << "\n";
+	for(unsigned int r = 0; r < sol.routes.size(); r++)
+	{
+		if( sol.routes[r].empty() )
+			continue;
+		os << "tour";
+		for(unsigned int i = 0; i < sol.routes[r].size(); i++)
+			os << " " << sol.routes[r][i];
+		os << "\n";
+	}
+	os.close();
+	if( os.fail() || rename( tmp.c_str(), path.c_str() ) != 0 )
+	{
+		cerr << "Cannot write checkpoint " << path << endl;
+		return false;
+	}
+	return true;
+}
+
+void Checkpoint::handleSignal( int sig )
+{
+	signalled = 1;
+	// the next signal kills the program
+	signal( sig, SIG_DFL );
+}
+
+void Checkpoint::watch()
+{
+	while( true )
+	{
+		usleep( 100000 );
+		if( !signalled )
+			continue;
+		lock_guard<mutex> guard(handlerLock);
+		if( !handled && interruptHandler )
+		{
+			cerr << "Interrupted, stopping the solver ..." << endl;
+			interruptHandler();
+			handled = true;
+		}
+	}
+}
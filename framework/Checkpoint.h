@@ -0,0 +1,63 @@
+#ifndef __CHECKPOINT__H__
+#define __CHECKPOINT__H__
+
+#include <mutex>
+#include <functional>
+#include "Tools.h"
+#include "Instance.h"
+#include "Solution.h"
+
+using namespace std;
+
+/**
+ * Keeps the best known solution of a long run on disk so that a run killed
+ * by the scheduler can be resumed from it (-r). The file is replaced
+ * atomically, a crash while writing leaves the previous checkpoint intact:
+ *
+ *   objective <value>
+ *   bound <value>			(only if known)
+ *   tour <station> <station> ...	(one line per tour, without the depot)
+ *
+ * The static part turns SIGINT and SIGTERM into a clean stop of the running
+ * solver, a second signal terminates the program right away.
+ */
+class Checkpoint
+{
+private:
+
+	string path;
+	double interval;	// minimum seconds between two periodic writes
+	double lastWrite;
+	Solution last;		// solution of the last write
+	double bound;		// best lower bound reported so far
+	mutex lock;
+
+	bool write( const Solution& sol );
+
+	static void handleSignal( int sig );
+	static void watch();
+
+public:
+
+	Checkpoint( const string& _path, double _interval = 60 );
+
+	const string& getPath() { return path; };
+
+	// writes the solution if it improves the file and the interval has
+	// passed (or force is set), bound is a lower bound or -infinity
+	void save( const Solution& sol, double _bound, bool force = false );
+
+	// forgets solution and bound of the last write, e.g. after the instance
+	// has changed, so that the next save() replaces the file
+	void reset();
+
+	// reads a checkpoint, returns false if it is missing or does not fit the instance
+	static bool load( const string& path, Instance& instance, Solution& sol );
+
+	// installs the signal handlers, the handler is called once (from a
+	// separate thread) when the first SIGINT or SIGTERM arrives
+	static void onInterrupt( function<void()> handler );
+	static bool interrupted();
+};
+
+#endif //__CHECKPOINT__H__
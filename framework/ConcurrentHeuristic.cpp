@@ -0,0 +1,146 @@
+#include "ConcurrentHeuristic.h"
+
+// number of pending seeds, older ones are dropped
+static const unsigned int MAX_SEEDS = 4;
+// milliseconds a worker waits after failing to build a solution, doubled per failure
+static const int MIN_BACKOFF = 10;
+static const int MAX_BACKOFF = 1000;
+
+bool SolutionPool::offer( const Solution& sol )
+{
+	lock_guard<mutex> guard(lock);
+	if( hasSolution && sol.cost >= best.cost - 1e-6 )
+		return false;
+	best = sol;
+	hasSolution = true;
+	return true;
+}
+
+bool SolutionPool::getBest( Solution& sol )
+{
+	lock_guard<mutex> guard(lock);
+	if( hasSolution )
+		sol = best;
+	return hasSolution;
+}
+
+void SolutionPool::clear()
+{
+	lock_guard<mutex> guard(lock);
+	hasSolution = false;
+}
+
+ConcurrentHeuristic::ConcurrentHeuristic( Instance& _instance, SolutionPool& _pool, int numThreads, RoutePool* _routes, const PairGraph* _pairs ) :
+instance( _instance ), pool( _pool ), routes( _routes ), pairs( _pairs ), stopping( false )
+{
+	for(int i = 0; i < numThreads; i++)
+		workers.push_back(thread(&ConcurrentHeuristic::run, this, i));
+}
+
+ConcurrentHeuristic::~ConcurrentHeuristic()
+{
+	stop();
+}
+
+void ConcurrentHeuristic::submit( const Solution& seed )
+{
+	lock_guard<mutex> guard(lock);
+	seeds.push_back(seed);
+	if( seeds.size() > MAX_SEEDS )
+		seeds.pop_front();
+	wakeUp.notify_one();
+}
+
+void ConcurrentHeuristic::stop()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for(unsigned int i = 0; i < workers.size(); i++)
+	{
+		if( workers[i].joinable() )
+			workers[i].join();
+	}
+}
+
+// ----- private methods -----------------------------------------------
+
+bool ConcurrentHeuristic::nextSeed( Solution& seed )
+{
+	lock_guard<mutex> guard(lock);
+	if( seeds.empty() )
+		return false;
+	// newest seeds first, they are the most promising ones
+	seed = seeds.back();
+	seeds.pop_back();
+	return true;
+}
+
+bool ConcurrentHeuristic::backOff( unsigned int failures )
+{
+	int millis = MAX_BACKOFF;
+	if( failures < 8 )
+		millis = min(MAX_BACKOFF, MIN_BACKOFF << failures);
+	unique_lock<mutex> guard(lock);
+	wakeUp.wait_for(guard, chrono::milliseconds(millis), [this]() { return stopping || !seeds.empty(); });
+	return !stopping;
+}
+
+void ConcurrentHeuristic::run( unsigned int id )
+{
+	LocalSearch ls(instance, id + 1, pairs);
+	Solution current;
+	bool hasCurrent = false;
+	// failed repairs and constructions in a row, e.g. on an infeasible instance
+	unsigned int failures = 0;
+
+	while( true )
+	{
+		{
+			lock_guard<mutex> guard(lock);
+			if( stopping )
+				return;
+		}
+
+		Solution sol;
+		if( nextSeed(sol) )
+		{
+			if( !ls.repair(sol) )
+			{
+				if( !hasCurrent && !backOff(failures++) )
+					return;
+				continue;
+			}
+		}
+		else if( !hasCurrent )
+		{
+			// no start solution yet, build one
+			if( !ls.construct(sol) )
+			{
+				if( !backOff(failures++) )
+					return;
+				continue;
+			}
+		}
+		else
+		{
+			// iterated local search from the best known solution
+			if( !pool.getBest(sol) )
+				sol = current;
+			ls.perturb(sol, 2 + id % 4);
+		}
+		failures = 0;
+
+		ls.improve(sol);
+		if( routes )
+			routes->add(instance, sol);
+		if( !hasCurrent || sol.cost < current.cost )
+		{
+			current = sol;
+			hasCurrent = true;
+		}
+		pool.offer(sol);
+	}
+}
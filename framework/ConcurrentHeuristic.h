@@ -0,0 +1,77 @@
+#ifndef __CONCURRENT_HEURISTIC__H__
+#define __CONCURRENT_HEURISTIC__H__
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include "Instance.h"
+#include "Solution.h"
+#include "LocalSearch.h"
+#include "RoutePool.h"
+#include "PairGraph.h"
+
+using namespace std;
+
+/** Thread-safe store for the best known solution. */
+class SolutionPool
+{
+private:
+
+	mutex lock;
+	Solution best;
+	bool hasSolution;
+
+public:
+
+	SolutionPool() : hasSolution( false ) {};
+
+	// keeps the solution if it is better than the best known one, returns true in that case
+	bool offer( const Solution& sol );
+
+	// copies the best known solution, returns false if there is none yet
+	bool getBest( Solution& sol );
+
+	// forgets the best known solution, e.g. after the instance has changed
+	void clear();
+};
+
+/**
+ * Runs iterated local search on background threads. Seeds (e.g. incumbents
+ * or rounded LP solutions of CPLEX) can be submitted at any time and are
+ * repaired and improved by the next idle worker, all improvements end up
+ * in the shared solution pool and their tours in the (optional) route pool.
+ */
+class ConcurrentHeuristic
+{
+private:
+
+	Instance& instance;
+	SolutionPool& pool;
+	RoutePool* routes;
+	const PairGraph* pairs;	// candidate supply nodes of the workers, all if null
+
+	vector<thread> workers;
+	mutex lock;
+	deque<Solution> seeds;
+	bool stopping;
+	condition_variable wakeUp;	// new seed or stop, ends the back-off of a failing worker
+
+	void run( unsigned int id );
+	bool nextSeed( Solution& seed );
+	// waits after the given number of failed constructions, false if stopping
+	bool backOff( unsigned int failures );
+
+public:
+
+	ConcurrentHeuristic( Instance& _instance, SolutionPool& _pool, int numThreads, RoutePool* _routes = 0, const PairGraph* _pairs = 0 );
+	~ConcurrentHeuristic();
+
+	// hands a (possibly infeasible) solution to the workers
+	void submit( const Solution& seed );
+
+	// stops and joins all workers
+	void stop();
+};
+
+#endif //__CONCURRENT_HEURISTIC__H__
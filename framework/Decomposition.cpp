@@ -0,0 +1,442 @@
+#include "Decomposition.h"
+
+Decomposition::Decomposition( Instance& _instance, const string& _engine, int _threads ) :
+instance( _instance ), engine( _engine ), threads( _threads ), timeLimit( 60 ), clusterDemands( 20 ), nextCluster( 0 ), aborted( false ), checkpoint( 0 )
+{
+}
+
+void Decomposition::abort()
+{
+	lock_guard<mutex> guard(lock);
+	aborted = true;
+	for(unsigned int i = 0; i < runningILPs.size(); i++)
+		runningILPs[i]->abort();
+	for(unsigned int i = 0; i < runningHeuristics.size(); i++)
+		runningHeuristics[i]->abort();
+}
+
+bool Decomposition::solve()
+{
+	double startTime = Tools::wallTime();
+
+	partition();
+	shareVehicles();
+
+	/*
+	 * solve the clusters in parallel, a share of the time is kept back for
+	 * clusters that need more vehicles and for the final local search
+	 */
+
+	unsigned int workers = max(1, min(threads, (int) clusters.size()));
+	unsigned int rounds = (clusters.size() + workers - 1) / workers;
+	double seconds = 0.8 * timeLimit / rounds;
+
+	cout << "Decomposed into " << clusters.size() << " clusters, solving them with " << engine
+		<< " on " << workers << " threads (" << seconds << " s each)\n";
+
+	nextCluster = 0;
+	vector<thread> pool;
+	for(unsigned int i = 0; i < workers; i++)
+		pool.push_back(thread(&Decomposition::work, this, seconds));
+	for(unsigned int i = 0; i < pool.size(); i++)
+		pool[i].join();
+
+	// vehicles allocated to but not used by the solved clusters
+	int spare = instance.m;
+	for(unsigned int c = 0; c < clusters.size(); c++)
+	{
+		if( !clusters[c].solved )
+		{
+			spare -= clusters[c].vehicles;
+			continue;
+		}
+		for(unsigned int r = 0; r < clusters[c].solution.routes.size(); r++)
+		{
+			if( !clusters[c].solution.routes[r].empty() )
+				spare--;
+		}
+	}
+
+	// clusters without a solution get another try with all spare vehicles
+	for(unsigned int c = 0; c < clusters.size() && spare > 0 && !aborted; c++)
+	{
+		if( clusters[c].solved )
+			continue;
+		clusters[c].vehicles += spare;
+		double remaining = timeLimit - (Tools::wallTime() - startTime);
+		solveCluster( clusters[c], max(1.0, remaining / 2) );
+		spare = clusters[c].vehicles;
+		if( clusters[c].solved )
+		{
+			for(unsigned int r = 0; r < clusters[c].solution.routes.size(); r++)
+			{
+				if( !clusters[c].solution.routes[r].empty() )
+					spare--;
+			}
+		}
+	}
+
+	/*
+	 * combine the tours of all clusters, demand nodes of clusters without a
+	 * solution are inserted by repair, then local search across the clusters
+	 */
+
+	Solution sol;
+	for(unsigned int c = 0; c < clusters.size(); c++)
+	{
+		if( !clusters[c].solved )
+			continue;
+		for(unsigned int r = 0; r < clusters[c].solution.routes.size(); r++)
+		{
+			if( !clusters[c].solution.routes[r].empty() )
+				sol.routes.push_back(clusters[c].solution.routes[r]);
+		}
+	}
+	double combined = sol.evaluate(instance);
+
+	LocalSearch ls( instance );
+	bool found = ls.repair(sol);
+	if( found )
+	{
+		ls.improve(sol);
+		sol.evaluate(instance);
+		found = sol.isFeasible(instance);
+	}
+	if( found && checkpoint )
+		checkpoint->save(sol, -1e30, true);
+
+	cout << "Decomposition finished." << "\n\n";
+	for(unsigned int c = 0; c < clusters.size(); c++)
+	{
+		cout << "Cluster " << c << ": " << clusters[c].stations.size() << " stations, " << clusters[c].demands
+			<< " demand nodes, " << clusters[c].vehicles << " vehicles, ";
+		if( clusters[c].solved )
+			cout << "objective " << clusters[c].objValue;
+		else
+			cout << "no solution";
+		cout << ", time " << clusters[c].time << " s\n";
+	}
+	cout << "Combined objective: " << combined << "\n";
+	if( found )
+		cout << "Objective value: " << sol.cost << "\n";
+	else
+		cout << "No feasible solution found.\n";
+	cout << "Wall time: " << Tools::wallTime() - startTime << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+	if( found )
+		sol.print( cout );
+	return found;
+}
+
+// ----- private methods -----------------------------------------------
+
+// assigns the nodes to the nearest medoid with capacity left, nodes with the
+// largest regret (second nearest minus nearest medoid) go first; nodes left
+// over when all capacity is used up stay unassigned
+void Decomposition::assign( const vector<int>& nodes, const vector<int>& medoids, vector<int> capacity, vector<int>& clusterOf )
+{
+	vector<pair<double, int> > order;
+	for(unsigned int i = 0; i < nodes.size(); i++)
+	{
+		double first = 1e30, second = 1e30;
+		for(unsigned int c = 0; c < medoids.size(); c++)
+		{
+			double d = distance(nodes[i], medoids[c]);
+			if( d < first )
+			{
+				second = first;
+				first = d;
+			}
+			else if( d < second )
+				second = d;
+		}
+		order.push_back(make_pair(first - second, i));
+	}
+	sort(order.begin(), order.end());
+
+	for(unsigned int k = 0; k < order.size(); k++)
+	{
+		int v = nodes[order[k].second];
+		int best = -1;
+		for(unsigned int c = 0; c < medoids.size(); c++)
+		{
+			if( capacity[c] > 0 && (best < 0 || distance(v, medoids[c]) < distance(v, medoids[best])) )
+				best = c;
+		}
+		if( best < 0 )
+			break;
+		capacity[best]--;
+		clusterOf[v] = best;
+	}
+}
+
+void Decomposition::partition()
+{
+	const vector<int>& supplies = instance.getSupplyNodes();
+	vector<int> demands;
+	for(unsigned int i = 0; i < instance.getDemandNodes().size(); i++)
+	{
+		if( instance.isRequired(instance.getDemandNodes()[i]) )
+			demands.push_back(instance.getDemandNodes()[i]);
+	}
+	int numS = supplies.size(), numD = demands.size();
+	int k = max(1, min(instance.m, min(numD, (numD + clusterDemands - 1) / clusterDemands)));
+
+	/*
+	 * initial medoids: demand nodes far away from the depot and from each other
+	 */
+
+	vector<int> medoids;
+	vector<double> minDist( numD, 1e30 );
+	int next = 0;
+	for(int i = 0; i < numD; i++)
+	{
+		minDist[i] = distance(0, demands[i]);
+		if( minDist[i] > minDist[next] )
+			next = i;
+	}
+	while( (int) medoids.size() < k && numD > 0 )
+	{
+		medoids.push_back(demands[next]);
+		for(int i = 0; i < numD; i++)
+			minDist[i] = min(minDist[i], distance(medoids.back(), demands[i]));
+		next = max_element(minDist.begin(), minDist.end()) - minDist.begin();
+	}
+	if( medoids.empty() )
+		medoids.push_back(0);
+	k = medoids.size();
+
+	/*
+	 * capacitated k-medoids: every cluster gets about the same number of
+	 * demand nodes and at least as many supply nodes as demand nodes
+	 */
+
+	vector<int> clusterOf( instance.n, -1 );
+	for(int iteration = 0; iteration < 20; iteration++)
+	{
+		assign(demands, medoids, vector<int>(k, (numD + k - 1) / k), clusterOf);
+
+		// one supply node per demand node first, then the surplus
+		vector<int> capacity( k, 0 );
+		for(int i = 0; i < numD; i++)
+			capacity[clusterOf[demands[i]]]++;
+		vector<int> left = supplies;
+		for(int i = 0; i < numS; i++)
+			clusterOf[supplies[i]] = -1;
+		for(int phase = 0; phase < 2; phase++)
+		{
+			assign(left, medoids, capacity, clusterOf);
+			left.clear();
+			for(int i = 0; i < numS; i++)
+			{
+				if( clusterOf[supplies[i]] < 0 )
+					left.push_back(supplies[i]);
+			}
+			capacity.assign(k, ((int) left.size() + k - 1) / k);
+		}
+
+		vector<vector<int> > members( k );
+		for(int v = 1; v < instance.n; v++)
+		{
+			if( clusterOf[v] >= 0 )
+				members[clusterOf[v]].push_back(v);
+		}
+
+		bool changed = false;
+		for(int c = 0; c < k; c++)
+		{
+			double bestSum = 1e30;
+			int best = medoids[c];
+			for(unsigned int i = 0; i < members[c].size(); i++)
+			{
+				double sum = 0;
+				for(unsigned int j = 0; j < members[c].size() && sum < bestSum; j++)
+					sum += distance(members[c][i], members[c][j]);
+				if( sum < bestSum )
+				{
+					bestSum = sum;
+					best = members[c][i];
+				}
+			}
+			changed = changed || best != medoids[c];
+			medoids[c] = best;
+		}
+		if( !changed )
+			break;
+	}
+
+	/*
+	 * clusters without demand nodes pass their supply nodes to the nearest
+	 * cluster with demand nodes
+	 */
+
+	vector<int> numDemands( k, 0 );
+	for(int i = 0; i < numD; i++)
+		numDemands[clusterOf[demands[i]]]++;
+	for(int i = 0; i < numS; i++)
+	{
+		int v = supplies[i];
+		if( numD == 0 || numDemands[clusterOf[v]] > 0 )
+			continue;
+		int best = -1;
+		for(int c = 0; c < k; c++)
+		{
+			if( numDemands[c] > 0 && (best < 0 || distance(v, medoids[c]) < distance(v, medoids[best])) )
+				best = c;
+		}
+		clusterOf[v] = best;
+	}
+
+	clusters.clear();
+	vector<int> index( k, -1 );
+	for(int v = 1; v < instance.n; v++)
+	{
+		int c = clusterOf[v];
+		if( c < 0 )
+			continue;
+		if( index[c] < 0 )
+		{
+			index[c] = clusters.size();
+			clusters.push_back(Cluster());
+			clusters.back().demands = 0;
+			clusters.back().vehicles = 0;
+			clusters.back().solved = false;
+			clusters.back().objValue = 0;
+			clusters.back().time = 0;
+		}
+		Cluster& cluster = clusters[index[c]];
+		cluster.stations.push_back(v);
+		if( instance.isDemandNode(v) )
+			cluster.demands++;
+	}
+}
+
+// estimates the travel time of every cluster by the cheapest arcs into and
+// out of its demand nodes and shares the vehicles out in proportion to it,
+// every cluster gets at least the vehicles this estimate needs
+void Decomposition::shareVehicles()
+{
+	vector<double> work( clusters.size(), 0 );
+	vector<int> needed( clusters.size(), 1 );
+	for(unsigned int c = 0; c < clusters.size(); c++)
+	{
+		const vector<int>& stations = clusters[c].stations;
+		double depot = 1e30;
+		for(unsigned int i = 0; i < stations.size(); i++)
+		{
+			depot = min(depot, instance.getDistance(0, stations[i]) + instance.getDistance(stations[i], 0));
+			if( !instance.isDemandNode(stations[i]) )
+				continue;
+			double in = 1e30, out = 1e30;
+			for(unsigned int j = 0; j < stations.size(); j++)
+			{
+				if( instance.isSupplyNode(stations[j]) )
+				{
+					in = min(in, instance.getDistance(stations[j], stations[i]));
+					out = min(out, instance.getDistance(stations[i], stations[j]));
+				}
+			}
+			// the last demand node of a tour returns to the depot instead
+			work[c] += in + min(out, instance.getDistance(stations[i], 0));
+		}
+		if( instance.T > depot )
+			needed[c] = max(1, (int) ceil(work[c] / (instance.T - depot)));
+		clusters[c].vehicles = 0;
+	}
+
+	int vehicles = instance.m;
+	for(unsigned int c = 0; c < clusters.size(); c++)
+	{
+		clusters[c].vehicles = 1;
+		vehicles--;
+	}
+	for(; vehicles > 0; vehicles--)
+	{
+		// clusters below their estimate first, then the largest work per vehicle
+		unsigned int best = 0;
+		for(unsigned int c = 1; c < clusters.size(); c++)
+		{
+			bool shortC = clusters[c].vehicles < needed[c], shortBest = clusters[best].vehicles < needed[best];
+			if( shortC != shortBest ? shortC
+				: work[c] * clusters[best].vehicles > work[best] * clusters[c].vehicles )
+				best = c;
+		}
+		clusters[best].vehicles++;
+	}
+}
+
+void Decomposition::solveCluster( Cluster& cluster, double seconds )
+{
+	double startTime = Tools::wallTime();
+	Instance sub;
+	sub.initialize( instance, cluster.stations, cluster.vehicles );
+
+	Solution local;
+	bool found;
+	if( engine == "heuristic" )
+	{
+		HeuristicSolver heuristic( sub );
+		heuristic.setTimeLimit( seconds );
+		heuristic.setRecombineInterval( min(10.0, seconds / 3) );
+		{
+			lock_guard<mutex> guard(lock);
+			runningHeuristics.push_back(&heuristic);
+			if( aborted )
+				heuristic.abort();
+		}
+		found = heuristic.solve( true );
+		{
+			lock_guard<mutex> guard(lock);
+			runningHeuristics.erase(find(runningHeuristics.begin(), runningHeuristics.end(), &heuristic));
+		}
+		local = heuristic.getSolution();
+	}
+	else
+	{
+		tcbvrp_ILP ilp( sub, engine, false );
+		ilp.setQuiet( true );
+		ilp.setTimeLimit( seconds );
+		{
+			lock_guard<mutex> guard(lock);
+			runningILPs.push_back(&ilp);
+			if( aborted )
+				ilp.abort();
+		}
+		found = ilp.solve() && ilp.getResult().hasSolution;
+		{
+			lock_guard<mutex> guard(lock);
+			runningILPs.erase(find(runningILPs.begin(), runningILPs.end(), &ilp));
+		}
+		local = ilp.getResult().solution;
+	}
+
+	// back to the node ids of the full instance
+	cluster.solved = found;
+	cluster.solution.routes.clear();
+	if( found )
+	{
+		for(unsigned int r = 0; r < local.routes.size(); r++)
+		{
+			cluster.solution.routes.push_back(vector<int>());
+			for(unsigned int i = 0; i < local.routes[r].size(); i++)
+				cluster.solution.routes.back().push_back(cluster.stations[local.routes[r][i] - 1]);
+		}
+		cluster.objValue = cluster.solution.evaluate(instance);
+	}
+	cluster.time = Tools::wallTime() - startTime;
+}
+
+void Decomposition::work( double seconds )
+{
+	while( true )
+	{
+		unsigned int c;
+		{
+			lock_guard<mutex> guard(lock);
+			if( nextCluster >= clusters.size() || aborted )
+				return;
+			c = nextCluster++;
+		}
+		solveCluster( clusters[c], seconds );
+	}
+}
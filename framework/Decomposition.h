@@ -0,0 +1,81 @@
+#ifndef __DECOMPOSITION__H__
+#define __DECOMPOSITION__H__
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "Tools.h"
+#include "Instance.h"
+#include "Solution.h"
+#include "LocalSearch.h"
+#include "HeuristicSolver.h"
+#include "tcbvrp_ILP.h"
+#include "Checkpoint.h"
+
+using namespace std;
+
+/**
+ * Cluster-first, route-second solver for instances too large for the full
+ * formulations. The stations are partitioned into balanced clusters around
+ * medoids of the (symmetrized) travel times, the vehicles are shared out by
+ * the number of demand nodes per cluster and every cluster is solved as a
+ * sub-instance of its own, several of them in parallel. The combined
+ * solution is finally improved by local search across cluster boundaries.
+ */
+class Decomposition
+{
+private:
+
+	Instance& instance;
+	string engine;			// heuristic or one of the formulations
+	int threads;
+	double timeLimit;		// seconds for all clusters together
+	int clusterDemands;		// target number of demand nodes per cluster
+
+	struct Cluster
+	{
+		vector<int> stations;	// original node ids, supply and required demand nodes
+		int demands;
+		int vehicles;
+
+		bool solved;
+		Solution solution;		// in original node ids
+		double objValue;
+		double time;
+	};
+
+	vector<Cluster> clusters;
+	mutex lock;
+	unsigned int nextCluster;	// next cluster to be taken by a worker
+
+	// solvers of the clusters being solved, guarded by lock
+	vector<tcbvrp_ILP*> runningILPs;
+	vector<HeuristicSolver*> runningHeuristics;
+	atomic<bool> aborted;
+	Checkpoint* checkpoint;
+
+	double distance( int i, int j ) { return (instance.getDistance(i, j) + instance.getDistance(j, i)) / 2; };
+	void assign( const vector<int>& nodes, const vector<int>& medoids, vector<int> capacity, vector<int>& clusterOf );
+	void partition();
+	void shareVehicles();
+	void solveCluster( Cluster& cluster, double seconds );
+	void work( double seconds );
+
+public:
+
+	Decomposition( Instance& _instance, const string& _engine = "heuristic", int _threads = 1 );
+
+	void setTimeLimit( double seconds ) { timeLimit = seconds; };
+	void setClusterDemands( int demands ) { clusterDemands = demands; };
+	// the combined solution is written to the checkpoint, also after abort()
+	void setCheckpoint( Checkpoint* _checkpoint ) { checkpoint = _checkpoint; };
+
+	// returns false if no feasible solution was found
+	bool solve();
+
+	// stops the cluster solvers, the clusters solved so far are still
+	// combined, thread-safe
+	void abort();
+};
+
+#endif //__DECOMPOSITION__H__
@@ -0,0 +1,349 @@
+#include "ExactSolver.h"
+
+ExactSolver::ExactSolver( Instance& _instance ) :
+instance( _instance ), timeLimit( 3600 ), labelLimit( 20000000 ), bestCost( 0 ), searchNodes( 0 ), deadline( 0 ), timedOut( false ), found( false ), aborted( false )
+{
+}
+
+bool ExactSolver::solve( bool quiet )
+{
+	double startTime = Tools::wallTime();
+	deadline = startTime + timeLimit;
+	timedOut = false;
+	found = false;
+	best = Solution();
+
+	bool complete = fits( instance ) && enumerateRoutes();
+	if( complete )
+	{
+		selectRoutes();
+		complete = !timedOut;
+	}
+	layers.clear();
+
+	if( quiet )
+		return complete;
+
+	cout << "Exact solver finished." << "\n\n";
+	cout << "Tours: " << routes.size() << " station sets, " << searchNodes << " selection nodes\n";
+	if( !fits( instance ) )
+		cout << "Too many stations for the exact solver (at most " << MAX_NODES - 1 << ").\n";
+	else if( !complete )
+		cout << "Time or label limit reached, no proof.\n";
+	if( found )
+		cout << "Objective value: " << best.cost << (complete ? " (optimal)" : "") << "\n";
+	else if( complete )
+		cout << "Instance is infeasible.\n";
+	cout << "Wall time: " << Tools::wallTime() - startTime << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+	if( found )
+		best.print( cout );
+	return complete;
+}
+
+// ----- private methods -----
+
+bool ExactSolver::enumerateRoutes()
+{
+	const vector<int>& supplyNodes = instance.getSupplyNodes();
+	vector<int> demandNodes;
+	for(unsigned int i = 0; i < instance.getDemandNodes().size(); i++)
+	{
+		if( instance.isRequired(instance.getDemandNodes()[i]) )
+			demandNodes.push_back(instance.getDemandNodes()[i]);
+	}
+
+	// every tour ends with an arc from a demand node to the depot
+	double minReturn = 1e30;
+	for(unsigned int i = 0; i < demandNodes.size(); i++)
+		minReturn = min(minReturn, instance.getDistance(demandNodes[i], 0));
+
+	unordered_map<uint64_t, int> cheapest;
+	routes.clear();
+	layers.assign(1, vector<unordered_map<uint64_t, Label> >(instance.n));
+	Label start = { 0, -1, 0 };
+	layers[0][0][0] = start;
+	size_t labels = 1;
+	size_t expanded = 0;
+
+	for(unsigned int k = 0; k < layers.size(); k++)
+	{
+		if( k < demandNodes.size() )
+			layers.push_back(vector<unordered_map<uint64_t, Label> >(instance.n));
+		for(int last = 0; last < instance.n; last++)
+		{
+			unordered_map<uint64_t, Label>& layer = layers[k][last];
+			for(unordered_map<uint64_t, Label>::iterator it = layer.begin(); it != layer.end(); ++it)
+			{
+				if( labels > labelLimit || ((++expanded & 0x3ff) == 0 && (aborted || Tools::wallTime() > deadline)) )
+					return false;
+
+				uint64_t visited = it->first;
+				double time = it->second.time;
+
+				// close the tour
+				if( k > 0 && time + instance.getDistance(last, 0) <= instance.T )
+				{
+					Route route = { visited, 0, time + instance.getDistance(last, 0), last, (int)k };
+					unordered_map<uint64_t, int>::iterator c = cheapest.find(visited);
+					if( c == cheapest.end() )
+					{
+						cheapest[visited] = routes.size();
+						routes.push_back(route);
+					}
+					else if( route.cost < routes[c->second].cost )
+						routes[c->second] = route;
+				}
+
+				// extend it by another supply/demand pair
+				if( k + 1 >= layers.size() )
+					continue;
+				for(unsigned int s = 0; s < supplyNodes.size(); s++)
+				{
+					int supply = supplyNodes[s];
+					if( visited & bit(supply) )
+						continue;
+					double toSupply = time + instance.getDistance(last, supply);
+					if( toSupply + minReturn > instance.T )
+						continue;
+					for(unsigned int d = 0; d < demandNodes.size(); d++)
+					{
+						int demand = demandNodes[d];
+						if( visited & bit(demand) )
+							continue;
+						double toDemand = toSupply + instance.getDistance(supply, demand);
+						if( toDemand + minReturn > instance.T )
+							continue;
+
+						uint64_t next = visited | bit(supply) | bit(demand);
+						unordered_map<uint64_t, Label>& target = layers[k+1][demand];
+						unordered_map<uint64_t, Label>::iterator l = target.find(next);
+						if( l == target.end() )
+						{
+							Label label = { toDemand, supply, last };
+							target[next] = label;
+							labels++;
+						}
+						else if( toDemand < l->second.time )
+						{
+							l->second.time = toDemand;
+							l->second.supply = supply;
+							l->second.pred = last;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void ExactSolver::selectRoutes()
+{
+	// the demand sets of the selection are numbered over the required demand nodes only
+	vector<int> demandNodes;
+	for(unsigned int i = 0; i < instance.getDemandNodes().size(); i++)
+	{
+		if( instance.isRequired(instance.getDemandNodes()[i]) )
+			demandNodes.push_back(instance.getDemandNodes()[i]);
+	}
+	int numDemands = demandNodes.size();
+
+	byDemand.assign(numDemands, vector<int>());
+	byDemandSet.clear();
+	share.assign(numDemands, 1e30);
+	for(unsigned int r = 0; r < routes.size(); r++)
+	{
+		routes[r].demands = 0;
+		for(int b = 0; b < numDemands; b++)
+		{
+			if( routes[r].stations & bit(demandNodes[b]) )
+			{
+				routes[r].demands |= (uint64_t)1 << b;
+				byDemand[b].push_back(r);
+				share[b] = min(share[b], routes[r].cost / routes[r].pairs);
+			}
+		}
+		byDemandSet[routes[r].demands].push_back(r);
+	}
+	struct ByCost
+	{
+		const vector<Route>& routes;
+		bool operator()( int a, int b ) const { return routes[a].cost < routes[b].cost; }
+	} byCost = { routes };
+	for(int b = 0; b < numDemands; b++)
+		sort(byDemand[b].begin(), byDemand[b].end(), byCost);
+	for(unordered_map<uint64_t, vector<int> >::iterator it = byDemandSet.begin(); it != byDemandSet.end(); ++it)
+		sort(it->second.begin(), it->second.end(), byCost);
+
+	/*
+	 * lower bound of the remaining cost: the cheapest cover of the uncovered
+	 * demand nodes by at most k tours which may share supply nodes, by subset
+	 * DP for few demand nodes; otherwise every tour's cost is split evenly
+	 * between its demand nodes and the cheapest shares are summed up
+	 */
+
+	cover.clear();
+	if( numDemands <= MAX_COVER_DEMANDS )
+	{
+		uint64_t sets = (uint64_t)1 << numDemands;
+		int maxTours = min(instance.m, numDemands);
+		vector<double> single(sets, 1e30);
+		for(unordered_map<uint64_t, vector<int> >::iterator it = byDemandSet.begin(); it != byDemandSet.end(); ++it)
+			single[it->first] = routes[it->second[0]].cost;
+		cover.assign(maxTours + 1, vector<double>(sets, 1e30));
+		cover[0][0] = 0;
+		for(int k = 1; k <= maxTours; k++)
+		{
+			cover[k] = cover[k-1];
+			for(uint64_t set = 1; set < sets; set++)
+			{
+				// the tour serving the lowest demand node of the set and the rest
+				uint64_t lowest = set & (~set + 1);
+				uint64_t others = set ^ lowest;
+				uint64_t sub = others;
+				while( true )
+				{
+					uint64_t tour = sub | lowest;
+					cover[k][set] = min(cover[k][set], single[tour] + cover[k-1][set ^ tour]);
+					if( sub == 0 )
+						break;
+					sub = (sub - 1) & others;
+				}
+			}
+		}
+	}
+
+	bestCost = 1e30;
+	searchNodes = 0;
+	selected.clear();
+	bestSelection.clear();
+	uint64_t all = numDemands == 64 ? ~(uint64_t)0 : ((uint64_t)1 << numDemands) - 1;
+	search(all, 0, 0, instance.m);
+
+	found = bestCost < 1e30;
+	if( !found )
+		return;
+	for(unsigned int i = 0; i < bestSelection.size(); i++)
+		best.routes.push_back(buildRoute(routes[bestSelection[i]]));
+	best.evaluate(instance);
+}
+
+void ExactSolver::search( uint64_t uncovered, uint64_t used, double cost, int vehicles )
+{
+	if( uncovered == 0 )
+	{
+		if( cost < bestCost )
+		{
+			bestCost = cost;
+			bestSelection = selected;
+		}
+		return;
+	}
+	if( vehicles == 0 || timedOut || cost + lowerBound(uncovered, vehicles) >= bestCost )
+		return;
+	if( (++searchNodes & 0xffff) == 0 && (aborted || Tools::wallTime() > deadline) )
+	{
+		timedOut = true;
+		return;
+	}
+
+	// the last tour has to cover all remaining demand nodes
+	if( vehicles == 1 )
+	{
+		unordered_map<uint64_t, vector<int> >::iterator it = byDemandSet.find(uncovered);
+		if( it == byDemandSet.end() )
+			return;
+		for(unsigned int i = 0; i < it->second.size(); i++)
+		{
+			const Route& route = routes[it->second[i]];
+			if( cost + route.cost >= bestCost )
+				return;
+			if( (route.stations & used) == 0 )
+			{
+				selected.push_back(it->second[i]);
+				search(0, used | route.stations, cost + route.cost, 0);
+				selected.pop_back();
+				return;
+			}
+		}
+		return;
+	}
+
+	// branch on the tour serving the lowest uncovered demand node
+	uint64_t lowest = uncovered & (~uncovered + 1);
+	if( !cover.empty() )
+	{
+		// by its demand set, the cover bound of the rest stops each set early
+		uint64_t others = uncovered ^ lowest;
+		uint64_t sub = others;
+		while( true )
+		{
+			uint64_t set = sub | lowest;
+			unordered_map<uint64_t, vector<int> >::iterator it = byDemandSet.find(set);
+			if( it != byDemandSet.end() )
+			{
+				double rest = lowerBound(uncovered ^ set, vehicles - 1);
+				for(unsigned int i = 0; i < it->second.size(); i++)
+				{
+					const Route& route = routes[it->second[i]];
+					if( cost + route.cost + rest >= bestCost )
+						break;
+					if( route.stations & used )
+						continue;
+					selected.push_back(it->second[i]);
+					search(uncovered ^ set, used | route.stations, cost + route.cost, vehicles - 1);
+					selected.pop_back();
+				}
+			}
+			if( sub == 0 )
+				break;
+			sub = (sub - 1) & others;
+		}
+		return;
+	}
+	int b = __builtin_ctzll(lowest);
+	for(unsigned int i = 0; i < byDemand[b].size(); i++)
+	{
+		const Route& route = routes[byDemand[b][i]];
+		if( cost + route.cost >= bestCost )
+			return;
+		if( route.stations & used )
+			continue;
+		selected.push_back(byDemand[b][i]);
+		search(uncovered & ~route.demands, used | route.stations, cost + route.cost, vehicles - 1);
+		selected.pop_back();
+	}
+}
+
+double ExactSolver::lowerBound( uint64_t uncovered, int vehicles )
+{
+	if( !cover.empty() )
+		return cover[min(vehicles, (int)cover.size() - 1)][uncovered];
+
+	double bound = 0;
+	while( uncovered )
+	{
+		bound += share[__builtin_ctzll(uncovered)];
+		uncovered &= uncovered - 1;
+	}
+	return bound;
+}
+
+vector<int> ExactSolver::buildRoute( const Route& route )
+{
+	// follow the labels back to the depot
+	vector<int> tour;
+	uint64_t visited = route.stations;
+	int last = route.last;
+	for(int k = route.pairs; k > 0; k--)
+	{
+		const Label& label = layers[k][last].find(visited)->second;
+		tour.push_back(last);
+		tour.push_back(label.supply);
+		visited &= ~(bit(last) | bit(label.supply));
+		last = label.pred;
+	}
+	reverse(tour.begin(), tour.end());
+	return tour;
+}
@@ -0,0 +1,109 @@
+#ifndef __EXACT_SOLVER__H__
+#define __EXACT_SOLVER__H__
+
+#include <atomic>
+#include <unordered_map>
+#include <stdint.h>
+#include "Tools.h"
+#include "Instance.h"
+#include "Solution.h"
+
+using namespace std;
+
+/**
+ * Exact native solver for small instances. All feasible tours are enumerated
+ * by dynamic programming over the set of visited stations (a bitset, so at
+ * most 64 stations) and the last demand node, the cheapest tour per station
+ * set is kept. The best selection of at most m station-disjoint tours
+ * covering every required demand node is then found by a depth-first search
+ * over the lowest uncovered demand node with a cost share lower bound.
+ */
+class ExactSolver
+{
+public:
+
+	// with --exact, instances up to this many nodes (depot included) are
+	// solved exactly before the selected engine, see Main
+	static const int AUTO_MAX_NODES = 21;
+	// seconds, the selected engine runs if the exact solver did not finish
+	static const int AUTO_TIME_LIMIT = 10;
+
+	// station sets are 64 bit masks
+	static const int MAX_NODES = 65;
+
+	// the exact cover bound of the route selection takes 3^d steps for d demand nodes
+	static const int MAX_COVER_DEMANDS = 16;
+
+private:
+
+	Instance& instance;
+	double timeLimit;	// seconds
+	size_t labelLimit;	// number of partial tours kept at most
+
+	// partial tour from the depot ending in a demand node (or the depot itself)
+	struct Label
+	{
+		double time;
+		int supply;		// supply node of the last pair, -1 for the empty tour
+		int pred;		// demand node before the last pair, 0 for the depot
+	};
+	// layers[k][last]: partial tours with k pairs ending in last, by visited stations
+	vector<vector<unordered_map<uint64_t, Label> > > layers;
+
+	// cheapest closed tour of a station set
+	struct Route
+	{
+		uint64_t stations;
+		uint64_t demands;	// bits of the required demand nodes, see selectRoutes()
+		double cost;
+		int last;
+		int pairs;
+	};
+	vector<Route> routes;
+
+	// route selection, over bits of the required demand nodes
+	vector<vector<int> > byDemand;		// routes containing a demand node, by cost
+	unordered_map<uint64_t, vector<int> > byDemandSet;	// routes covering a demand set, by cost
+	vector<vector<double> > cover;		// cover[k][set]: cheapest k tours covering the set, may share supplies
+	vector<double> share;				// lower bound on the cost per demand node
+	vector<int> selected, bestSelection;
+	double bestCost;
+	long searchNodes;
+	double deadline;
+	bool timedOut;
+
+	Solution best;
+	bool found;
+	atomic<bool> aborted;
+
+	static uint64_t bit( int node ) { return (uint64_t)1 << (node - 1); };
+
+	bool enumerateRoutes();
+	void selectRoutes();
+	void search( uint64_t uncovered, uint64_t used, double cost, int vehicles );
+	double lowerBound( uint64_t uncovered, int vehicles );
+	vector<int> buildRoute( const Route& route );
+
+public:
+
+	ExactSolver( Instance& _instance );
+
+	void setTimeLimit( double seconds ) { timeLimit = seconds; };
+	void setLabelLimit( size_t labels ) { labelLimit = labels; };
+
+	// true if the instance has few enough stations for the station bitsets
+	static bool fits( Instance& instance ) { return instance.n <= MAX_NODES; };
+
+	// returns true if the search finished, i.e. getSolution() is optimal or, if
+	// hasSolution() is false, the instance is infeasible; false if the time or
+	// label limit was hit
+	bool solve( bool quiet = false );
+
+	bool hasSolution() { return found; };
+	const Solution& getSolution() { return best; };
+
+	// stops a running solve() as soon as possible, thread-safe
+	void abort() { aborted = true; };
+};
+
+#endif //__EXACT_SOLVER__H__
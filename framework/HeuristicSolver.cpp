@@ -0,0 +1,93 @@
+#include "HeuristicSolver.h"
+
+// share of the time limit kept for the final recombination (at most one interval)
+static const double FINAL_RECOMBINE_SHARE = 0.1;
+
+HeuristicSolver::HeuristicSolver( Instance& _instance, int _threads ) :
+instance( _instance ), threads( _threads ), timeLimit( 60 ), recombineInterval( 10 ), hasStart( false ), aborted( false ), checkpoint( 0 )
+{
+}
+
+bool HeuristicSolver::solve( bool quiet )
+{
+	double startTime = Tools::wallTime();
+	SolutionPool pool;
+	RoutePool routes;
+	int recombinations = 0;
+
+	Solution warm = start;
+	bool hasWarm = false;
+	if( hasStart )
+	{
+		LocalSearch ls( instance );
+		hasWarm = ls.repair( warm );
+		if( hasWarm )
+		{
+			ls.improve( warm );
+			pool.offer( warm );
+			routes.add( instance, warm );
+		}
+	}
+
+	ConcurrentHeuristic heuristic( instance, pool, max(threads, 1), &routes );
+	if( hasWarm )
+		heuristic.submit( warm );
+
+	double finalReserve = recombineInterval > 0 ? min(recombineInterval, FINAL_RECOMBINE_SHARE * timeLimit) : 0;
+	double nextRecombination = startTime + recombineInterval;
+	while( !aborted && Tools::wallTime() - startTime < timeLimit - finalReserve )
+	{
+		usleep( 100000 );
+		if( checkpoint )
+		{
+			Solution sol;
+			if( pool.getBest(sol) )
+				checkpoint->save(sol, -1e30);
+		}
+		if( recombineInterval <= 0 || Tools::wallTime() < nextRecombination )
+			continue;
+
+		// select the best combination of all tours found so far
+		Solution sol;
+		pool.getBest(sol);
+		double remaining = timeLimit - (Tools::wallTime() - startTime);
+		if( remaining > 1 && routes.recombine(instance, sol, min(remaining, recombineInterval)) )
+		{
+			pool.offer(sol);
+			heuristic.submit(sol);
+			recombinations++;
+		}
+		nextRecombination = Tools::wallTime() + recombineInterval;
+	}
+	heuristic.stop();
+
+	// the final recombination only gets the time left
+	double remaining = timeLimit - (Tools::wallTime() - startTime);
+	if( recombineInterval > 0 && !aborted && remaining > 0 )
+	{
+		Solution sol;
+		if( pool.getBest(sol) && routes.recombine(instance, sol, min(remaining, recombineInterval)) )
+		{
+			pool.offer(sol);
+			recombinations++;
+		}
+	}
+
+	bool found = pool.getBest(best);
+	if( found && checkpoint )
+		checkpoint->save(best, -1e30, true);
+	if( quiet )
+		return found;
+
+	cout << "Heuristic finished." << "\n\n";
+	cout << "Route pool: " << routes.size() << " tours, " << recombinations << " improving recombinations\n";
+	if( found )
+		cout << "Objective value: " << best.cost << "\n";
+	else
+		cout << "No feasible solution found.\n";
+	cout << "Wall time: " << Tools::wallTime() - startTime << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+	if( found )
+		best.print( cout );
+	return found;
+}
@@ -0,0 +1,54 @@
+#ifndef __HEURISTIC_SOLVER__H__
+#define __HEURISTIC_SOLVER__H__
+
+#include <atomic>
+#include "Tools.h"
+#include "Instance.h"
+#include "Solution.h"
+#include "ConcurrentHeuristic.h"
+#include "RoutePool.h"
+#include "Checkpoint.h"
+
+using namespace std;
+
+/**
+ * Native heuristic: iterated local search on several threads for a fixed
+ * time, the tours found are periodically recombined by set partitioning.
+ */
+class HeuristicSolver
+{
+private:
+
+	Instance& instance;
+	int threads;
+	double timeLimit;			// seconds
+	double recombineInterval;	// seconds between two recombinations, 0 disables them
+
+	Solution best;
+	Solution start;
+	bool hasStart;
+	atomic<bool> aborted;
+	Checkpoint* checkpoint;
+
+public:
+
+	HeuristicSolver( Instance& _instance, int _threads = 1 );
+
+	void setTimeLimit( double seconds ) { timeLimit = seconds; };
+	void setRecombineInterval( double seconds ) { recombineInterval = seconds; };
+	void setCheckpoint( Checkpoint* _checkpoint ) { checkpoint = _checkpoint; };
+
+	// warm start, e.g. the previous solution after the instance has changed;
+	// it is repaired if it became infeasible
+	void setStartSolution( const Solution& sol ) { start = sol; hasStart = true; };
+
+	// returns false if no feasible solution was found
+	bool solve( bool quiet = false );
+
+	const Solution& getSolution() { return best; };
+
+	// stops a running solve() within a fraction of a second, thread-safe
+	void abort() { aborted = true; };
+};
+
+#endif //__HEURISTIC_SOLVER__H__
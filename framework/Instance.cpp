@@ -3,53 +3,127 @@
 
 void Instance::initialize( const string &fname )
 {
-	string d_s = "";
-	int d_i;
-
 	// input file stream
 	ifstream is( fname.c_str(), ios::in );
 
 	if ( is.is_open() )
 	{
-		// read number of nodes
-		std::getline(is, d_s);
-		n = atoi(d_s.c_str()) + 1;
-
-		// read global time limit per route
-		getline(is, d_s);
-		T = atoi(d_s.c_str());
-
-		// read number of vehicles
-		getline(is, d_s);
-		m = atoi(d_s.c_str());
-
-		// read supply and demand nodes
-		for (int i = 0; i < n - 1; i++) {
-			is >> d_i;
-			is >> d_s;
-			if (d_s == "S")
-				supplyNodes.push_back(d_i);
-			else
-				demandNodes.push_back(d_i);
+		if ( !read(is) )
+			cerr << "Cannot parse file " << fname.c_str() << ": " << parseError << endl;
+	}
+	else {
+		cerr << "Cannot open file " << fname.c_str() << endl;
+	}
+
+	is.close();
+}
+
+bool Instance::read( istream &is )
+{
+	string d_s = "";
+	int d_i;
+	parseError = "";
+
+	// read number of nodes
+	std::getline(is, d_s);
+	n = atoi(d_s.c_str()) + 1;
+
+	// read global time limit per route
+	getline(is, d_s);
+	T = atoi(d_s.c_str());
+
+	// read number of vehicles
+	getline(is, d_s);
+	m = atoi(d_s.c_str());
+
+	if (n < 2 || m < 1 || n > MAX_READ_NODES) {
+		parseError = "invalid number of stations or vehicles";
+		return false;
+	}
+
+	// read supply and demand nodes, every station 1..n-1 exactly once
+	supplyNodes.clear();
+	demandNodes.clear();
+	vector<bool> seen(n, false);
+	for (int i = 0; i < n - 1; i++) {
+		is >> d_i;
+		is >> d_s;
+		if (is.fail()) {
+			parseError = "missing station " + to_string(i + 1);
+			return false;
 		}
+		if (d_i < 1 || d_i >= n || seen[d_i] || (d_s != "S" && d_s != "D")) {
+			parseError = "invalid station line " + to_string(i + 1) + ": " + to_string(d_i) + " " + d_s;
+			return false;
+		}
+		seen[d_i] = true;
+		if (d_s == "S")
+			supplyNodes.push_back(d_i);
+		else
+			demandNodes.push_back(d_i);
+	}
 
-		// read distances
-		for (int i = 0;  i < n * n; i++) {
-			is >> d_i;
-			t.push_back(d_i);
+	// read distances
+	t.clear();
+	for (int i = 0;  i < n * n; i++) {
+		is >> d_i;
+		if (is.fail()) {
+			parseError = "missing distance " + to_string(i / n) + " " + to_string(i % n);
+			return false;
 		}
+		t.push_back(d_i);
+	}
+
+	// initially every demand node has to be served
+	required.assign(n, false);
+	for (uint i = 0; i < demandNodes.size(); i++)
+		required[demandNodes[i]] = true;
+
+	buildArcs();
+	return true;
+}
+
+void Instance::initialize( Instance &parent, const vector<int> &stations, int vehicles )
+{
+	n = stations.size() + 1;
+	T = parent.T;
+	m = vehicles;
 
+	// node 0 stays the depot
+	vector<int> nodes( 1, 0 );
+	nodes.insert(nodes.end(), stations.begin(), stations.end());
+
+	supplyNodes.clear();
+	demandNodes.clear();
+	required.assign(n, false);
+	for (int i = 1; i < n; i++) {
+		if (parent.isSupplyNode(nodes[i]))
+			supplyNodes.push_back(i);
+		else {
+			demandNodes.push_back(i);
+			required[i] = parent.isRequired(nodes[i]);
+		}
 	}
-	else {
-		cerr << "Cannot open file " << fname.c_str() << endl;
+
+	t.resize(n * n);
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++)
+			t[i*n+j] = parent.getDistance(nodes[i], nodes[j]);
 	}
 
-	is.close();
+	buildArcs();
+}
+
+// ----- private methods -----------------------------------------------
+
+void Instance::buildArcs()
+{
+	updateDistanceType();
 
 	//store arcs
 	arcs.resize(n*n);
 	nArcs = n * n;
-	incidentArcs.resize(n);
+	incidentArcs.assign(n, list<unsigned int>());
 
 	for (int i = 0; i < n; i++) {
 		for (int j = 0; j < n; j++) {
@@ -61,3 +135,22 @@ void Instance::initialize( const string &fname )
 		}
 	}
 }
+
+void Instance::updateDistanceType()
+{
+	double max = 0;
+	bool integral = true;
+	for (uint i = 0; i < t.size(); i++) {
+		if (t[i] > max)
+			max = t[i];
+		if (t[i] < 0 || t[i] != floor(t[i]))
+			integral = false;
+	}
+
+	if (!integral || max > 4294967295.0)
+		distanceType = DIST_DOUBLE;
+	else if (max > 65535)
+		distanceType = DIST_UINT32;
+	else
+		distanceType = DIST_UINT16;
+}
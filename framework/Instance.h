@@ -23,6 +23,25 @@ private:
 	std::vector<int> supplyNodes;
 	std::vector<int> demandNodes;
 
+	// demand nodes which currently have to be served
+	std::vector<bool> required;
+
+	// reason of the last failed read()
+	std::string parseError;
+
+	// fills arcs and incidentArcs from the travel times
+	void buildArcs();
+
+public:
+
+	// narrowest type holding all travel times exactly
+	enum DistanceType { DIST_UINT16, DIST_UINT32, DIST_DOUBLE };
+
+private:
+
+	DistanceType distanceType;
+	void updateDistanceType();
+
 public:
 
 	// total number of nodes (depot plus stations)
@@ -37,6 +56,16 @@ public:
 	// get distance between two nodes
 	double getDistance(int i, int j) { return t[(i*n+j)]; };
 
+	// change the distance between two nodes of a loaded instance
+	void setDistance(int i, int j, double d) {
+		t[(i*n+j)] = d;
+		arcs[j + n * i].weight = d;
+		updateDistanceType();
+	};
+
+	// value range of the travel times, decides which search kernel is used
+	DistanceType getDistanceType() { return distanceType; };
+
 
 	struct Arc
 	{
@@ -55,6 +84,18 @@ public:
 	// loads TCBVRP instance in the specified filename.
 	void initialize( const std::string &fname );
 
+	// largest number of nodes read() accepts, the travel times take n*n entries
+	static const int MAX_READ_NODES = 2000;
+
+	// reads an instance in the same format from a stream, returns false on parse
+	// errors (also on station ids outside 1..n-1 or listed twice), see getParseError()
+	bool read( std::istream &is );
+	const std::string& getParseError() { return parseError; }
+
+	// sub-instance of the depot and the given stations of parent with the given
+	// number of vehicles, station stations[i] becomes node i+1
+	void initialize( Instance &parent, const std::vector<int> &stations, int vehicles );
+
 	//Constructor
 	Instance( const std::string &fname) {
 		initialize(fname);
@@ -63,6 +104,10 @@ public:
 	//standard constructor, initialize must be called
 	Instance() {};
 
+	// supply and demand stations of the instance
+	const std::vector<int>& getSupplyNodes() { return supplyNodes; }
+	const std::vector<int>& getDemandNodes() { return demandNodes; }
+
 	// Returns true if node s is a supply node
 	bool isSupplyNode(int s) {
 		for (uint i = 0; i < supplyNodes.size(); i++) {
@@ -81,6 +126,22 @@ public:
 		return false;
 	}
 
+	// Returns true if demand node d has to be served (all of them after loading)
+	bool isRequired(int d) { return required[d]; }
+
+	// add (required) or cancel a demand node of a loaded instance
+	void setRequired(int d, bool r) { required[d] = r; }
+
+	// number of demand nodes which have to be served
+	int numRequiredDemands() {
+		int count = 0;
+		for (uint i = 0; i < demandNodes.size(); i++) {
+			if (required[demandNodes[i]])
+				count++;
+		}
+		return count;
+	}
+
 };
 
 #endif //__INSTANCE__H__
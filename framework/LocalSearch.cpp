@@ -0,0 +1,486 @@
+#include "LocalSearch.h"
+
+// minimal improvement for a move to be accepted
+static const double EPS = 1e-6;
+
+// sets the first size entries of a per-station container
+template<typename T, size_t K> static void fillNodes( array<T, K>& nodes, int size, T value ) { fill(nodes.begin(), nodes.begin() + size, value); }
+template<typename T> static void fillNodes( vector<T>& nodes, int size, T value ) { nodes.assign(size, value); }
+
+LocalSearch::LocalSearch( Instance& _instance, unsigned int seed, const PairGraph* pairs )
+{
+	if( _instance.n <= SMALL_NODES )
+		kernel = createKernel<SMALL_NODES>( _instance, seed, pairs );
+	else if( _instance.n <= MEDIUM_NODES )
+		kernel = createKernel<MEDIUM_NODES>( _instance, seed, pairs );
+	else
+		kernel = createKernel<0>( _instance, seed, pairs );
+}
+
+template<int N>
+LocalSearchBase* LocalSearch::createKernel( Instance& instance, unsigned int seed, const PairGraph* pairs )
+{
+	switch( instance.getDistanceType() )
+	{
+		case Instance::DIST_UINT16:
+			return new LocalSearchKernel<uint16_t, N>( instance, seed, pairs );
+		case Instance::DIST_UINT32:
+			return new LocalSearchKernel<uint32_t, N>( instance, seed, pairs );
+		default:
+			return new LocalSearchKernel<double, N>( instance, seed, pairs );
+	}
+}
+
+template<typename D, int N>
+LocalSearchKernel<D, N>::LocalSearchKernel( Instance& _instance, unsigned int seed, const PairGraph* pairs ) :
+instance( _instance ), rng( seed ), n( _instance.n ), restricted( pairs != 0 )
+{
+	int stride = N > 0 ? N : n;
+	fillNodes(t, stride * stride, (D) 0);
+	for(int i = 0; i < n; i++)
+	{
+		for(int j = 0; j < n; j++)
+			t[i*stride+j] = (D) instance.getDistance(i, j);
+	}
+
+	supplyNodes = instance.getSupplyNodes();
+	const vector<int>& allDemandNodes = instance.getDemandNodes();
+	for(unsigned int i = 0; i < allDemandNodes.size(); i++)
+	{
+		// cancelled demand nodes are treated like unknown nodes
+		if( instance.isRequired(allDemandNodes[i]) )
+			demandNodes.push_back(allDemandNodes[i]);
+	}
+
+	fillNodes(nodeType, n, (char) 0);
+	for(unsigned int i = 0; i < supplyNodes.size(); i++)
+		nodeType[supplyNodes[i]] = 'S';
+	for(unsigned int i = 0; i < demandNodes.size(); i++)
+		nodeType[demandNodes[i]] = 'D';
+
+	candidates.assign(n, vector<int>());
+	for(unsigned int i = 0; i < demandNodes.size(); i++)
+		candidates[demandNodes[i]] = pairs ? pairs->getSupplies(demandNodes[i]) : supplyNodes;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::construct( Solution& sol )
+{
+	sol.routes.assign(instance.m, vector<int>());
+	prepare(sol);
+
+	vector<int> order = demandNodes;
+	shuffle(order.begin(), order.end(), rng);
+	for(unsigned int i = 0; i < order.size(); i++)
+	{
+		if( !insertDemand(sol, order[i]) )
+			return false;
+	}
+	sol.evaluate(instance);
+	return true;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::repair( Solution& sol )
+{
+	sol.routes.resize(instance.m);
+	fillNodes(used, n, (char) false);
+
+	/*
+	 * keep only supply/demand pairs of unvisited stations in their order
+	 */
+
+	for(unsigned int r = 0; r < sol.routes.size(); r++)
+	{
+		vector<int> cleaned;
+		int supply = -1;
+		for(unsigned int i = 0; i < sol.routes[r].size(); i++)
+		{
+			int v = sol.routes[r][i];
+			if( v <= 0 || v >= instance.n || used[v] )
+				continue;
+			if( nodeType[v] == 'S' )
+				supply = v;
+			else if( nodeType[v] == 'D' && supply >= 0 && isCandidate(supply, v) )
+			{
+				cleaned.push_back(supply);
+				cleaned.push_back(v);
+				used[supply] = used[v] = true;
+				supply = -1;
+			}
+		}
+		sol.routes[r] = cleaned;
+	}
+
+	times.resize(sol.routes.size());
+	for(unsigned int r = 0; r < sol.routes.size(); r++)
+		times[r] = routeTime(sol.routes[r]);
+
+	/*
+	 * drop the most expensive pairs of tours exceeding the time limit
+	 */
+
+	for(unsigned int r = 0; r < sol.routes.size(); r++)
+	{
+		vector<int>& route = sol.routes[r];
+		while( times[r] > instance.T )
+		{
+			unsigned int worst = 0;
+			Time worstGain = -1;
+			for(unsigned int p = 0; p < route.size(); p += 2)
+			{
+				int prev = p == 0 ? 0 : route[p-1];
+				int next = p + 2 == route.size() ? 0 : route[p+2];
+				Time gain = (Time) dist(prev, route[p])
+					+ dist(route[p], route[p+1])
+					+ dist(route[p+1], next)
+					- dist(prev, next);
+				if( gain > worstGain )
+				{
+					worstGain = gain;
+					worst = p;
+				}
+			}
+			used[route[worst]] = used[route[worst+1]] = false;
+			route.erase(route.begin() + worst, route.begin() + worst + 2);
+			times[r] = routeTime(route);
+		}
+	}
+
+	/*
+	 * insert the uncovered demand nodes
+	 */
+
+	for(unsigned int i = 0; i < demandNodes.size(); i++)
+	{
+		if( !used[demandNodes[i]] && !insertDemand(sol, demandNodes[i]) )
+			return false;
+	}
+	sol.evaluate(instance);
+	return true;
+}
+
+template<typename D, int N>
+void LocalSearchKernel<D, N>::improve( Solution& sol )
+{
+	prepare(sol);
+	while( exchangeSupplies(sol) || relocatePairs(sol) || swapPairs(sol) || reversePairs(sol) )
+		;
+	sol.evaluate(instance);
+}
+
+template<typename D, int N>
+void LocalSearchKernel<D, N>::perturb( Solution& sol, int strength )
+{
+	prepare(sol);
+	int numRoutes = sol.routes.size();
+
+	for(int k = 0; k < strength; k++)
+	{
+		int a = rng() % numRoutes;
+		vector<int>& A = sol.routes[a];
+		if( A.empty() )
+			continue;
+		int p = 2 * (rng() % (A.size() / 2));
+
+		if( rng() % 3 == 0 )
+		{
+			// replace the supply node of the pair by a random unused candidate
+			const vector<int>& supplies = candidates[A[p+1]];
+			if( supplies.empty() )
+				continue;
+			int u = supplies[rng() % supplies.size()];
+			if( used[u] )
+				continue;
+			int s = A[p];
+			A[p] = u;
+			Time time = routeTime(A);
+			if( time <= instance.T )
+			{
+				used[s] = false;
+				used[u] = true;
+				times[a] = time;
+			}
+			else
+				A[p] = s;
+		}
+		else
+		{
+			// move the pair to a random position of a random tour
+			int b = rng() % numRoutes;
+			int s = A[p], d = A[p+1];
+			A.erase(A.begin() + p, A.begin() + p + 2);
+			vector<int>& B = sol.routes[b];
+			int q = 2 * (rng() % (B.size() / 2 + 1));
+			B.insert(B.begin() + q, d);
+			B.insert(B.begin() + q, s);
+			Time timeA = routeTime(A);
+			Time timeB = routeTime(B);
+			if( timeA <= instance.T && timeB <= instance.T )
+			{
+				times[a] = timeA;
+				times[b] = timeB;
+			}
+			else
+			{
+				B.erase(B.begin() + q, B.begin() + q + 2);
+				A.insert(A.begin() + p, d);
+				A.insert(A.begin() + p, s);
+			}
+		}
+	}
+	sol.evaluate(instance);
+}
+
+// ----- private methods -----------------------------------------------
+
+template<typename D, int N>
+typename LocalSearchKernel<D, N>::Time LocalSearchKernel<D, N>::routeTime( const vector<int>& route ) const
+{
+	if( route.empty() )
+		return 0;
+
+	const int* v = &route[0];
+	unsigned int len = route.size();
+	Time time = dist(0, v[0]);
+	for(unsigned int i = 1; i < len; i++)
+		time += dist(v[i-1], v[i]);
+	return time + dist(v[len-1], 0);
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::isCandidate( int s, int d ) const
+{
+	if( !restricted )
+		return true;
+	const vector<int>& supplies = candidates[d];
+	return find(supplies.begin(), supplies.end(), s) != supplies.end();
+}
+
+template<typename D, int N>
+void LocalSearchKernel<D, N>::prepare( Solution& sol )
+{
+	// empty tours are kept as insertion targets for unused vehicles
+	if( (int) sol.routes.size() < instance.m )
+		sol.routes.resize(instance.m);
+
+	fillNodes(used, n, (char) false);
+	times.resize(sol.routes.size());
+	for(unsigned int r = 0; r < sol.routes.size(); r++)
+	{
+		for(unsigned int i = 0; i < sol.routes[r].size(); i++)
+			used[sol.routes[r][i]] = true;
+		times[r] = routeTime(sol.routes[r]);
+	}
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::accept( Solution& sol, int a, int b )
+{
+	// tours a and b have been modified, keep the move if it is feasible and improving
+	Time timeA = routeTime(sol.routes[a]);
+	Time timeB = a == b ? 0 : routeTime(sol.routes[b]);
+	Time before = times[a] + (a == b ? 0 : times[b]);
+
+	if( timeA > instance.T || timeB > instance.T || timeA + timeB + EPS >= before )
+		return false;
+
+	times[a] = timeA;
+	if( a != b )
+		times[b] = timeB;
+	return true;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::insertDemand( Solution& sol, int d )
+{
+	int bestSupply = -1, bestRoute = -1, bestPos = -1;
+	Time bestDelta = 0;
+
+	const vector<int>& supplies = candidates[d];
+	for(unsigned int i = 0; i < supplies.size(); i++)
+	{
+		int s = supplies[i];
+		if( used[s] )
+			continue;
+		Time pairTime = dist(s, d);
+
+		for(unsigned int r = 0; r < sol.routes.size(); r++)
+		{
+			const vector<int>& route = sol.routes[r];
+			for(unsigned int q = 0; q <= route.size(); q += 2)
+			{
+				int prev = q == 0 ? 0 : route[q-1];
+				int next = q == route.size() ? 0 : route[q];
+				Time delta = (Time) dist(prev, s) + pairTime
+					+ dist(d, next) - dist(prev, next);
+				if( times[r] + delta <= instance.T && (bestSupply < 0 || delta < bestDelta) )
+				{
+					bestSupply = s;
+					bestRoute = r;
+					bestPos = q;
+					bestDelta = delta;
+				}
+			}
+		}
+	}
+
+	if( bestSupply < 0 )
+		return false;
+
+	vector<int>& route = sol.routes[bestRoute];
+	route.insert(route.begin() + bestPos, d);
+	route.insert(route.begin() + bestPos, bestSupply);
+	times[bestRoute] += bestDelta;
+	used[bestSupply] = used[d] = true;
+	return true;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::exchangeSupplies( Solution& sol )
+{
+	for(unsigned int a = 0; a < sol.routes.size(); a++)
+	{
+		vector<int>& A = sol.routes[a];
+		for(unsigned int p = 0; p < A.size(); p += 2)
+		{
+			int s = A[p];
+
+			// replace by an unused supply node
+			const vector<int>& supplies = candidates[A[p+1]];
+			for(unsigned int i = 0; i < supplies.size(); i++)
+			{
+				int u = supplies[i];
+				if( used[u] )
+					continue;
+				A[p] = u;
+				if( accept(sol, a, a) )
+				{
+					used[s] = false;
+					used[u] = true;
+					return true;
+				}
+				A[p] = s;
+			}
+
+			// exchange with the supply node of another pair
+			for(unsigned int b = a; b < sol.routes.size(); b++)
+			{
+				vector<int>& B = sol.routes[b];
+				for(unsigned int q = (a == b ? p + 2 : 0); q < B.size(); q += 2)
+				{
+					if( !isCandidate(B[q], A[p+1]) || !isCandidate(A[p], B[q+1]) )
+						continue;
+					swap(A[p], B[q]);
+					if( accept(sol, a, b) )
+						return true;
+					swap(A[p], B[q]);
+				}
+			}
+		}
+	}
+	return false;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::relocatePairs( Solution& sol )
+{
+	for(unsigned int a = 0; a < sol.routes.size(); a++)
+	{
+		vector<int>& A = sol.routes[a];
+		for(unsigned int p = 0; p < A.size(); p += 2)
+		{
+			int s = A[p], d = A[p+1];
+			A.erase(A.begin() + p, A.begin() + p + 2);
+
+			for(unsigned int b = 0; b < sol.routes.size(); b++)
+			{
+				vector<int>& B = sol.routes[b];
+
+				// only one empty tour has to be tried
+				if( B.empty() && a != b && b > 0 && sol.routes[b-1].empty() )
+					continue;
+
+				for(unsigned int q = 0; q <= B.size(); q += 2)
+				{
+					if( a == b && q == p )
+						continue;
+					B.insert(B.begin() + q, d);
+					B.insert(B.begin() + q, s);
+					if( accept(sol, a, b) )
+						return true;
+					B.erase(B.begin() + q, B.begin() + q + 2);
+				}
+			}
+
+			A.insert(A.begin() + p, d);
+			A.insert(A.begin() + p, s);
+		}
+	}
+	return false;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::swapPairs( Solution& sol )
+{
+	for(unsigned int a = 0; a < sol.routes.size(); a++)
+	{
+		vector<int>& A = sol.routes[a];
+		for(unsigned int p = 0; p < A.size(); p += 2)
+		{
+			for(unsigned int b = a; b < sol.routes.size(); b++)
+			{
+				vector<int>& B = sol.routes[b];
+				for(unsigned int q = (a == b ? p + 2 : 0); q < B.size(); q += 2)
+				{
+					swap(A[p], B[q]);
+					swap(A[p+1], B[q+1]);
+					if( accept(sol, a, b) )
+						return true;
+					swap(A[p], B[q]);
+					swap(A[p+1], B[q+1]);
+				}
+			}
+		}
+	}
+	return false;
+}
+
+template<typename D, int N>
+bool LocalSearchKernel<D, N>::reversePairs( Solution& sol )
+{
+	for(unsigned int a = 0; a < sol.routes.size(); a++)
+	{
+		vector<int>& A = sol.routes[a];
+		for(unsigned int p = 0; p < A.size(); p += 2)
+		{
+			for(unsigned int q = p + 2; q < A.size(); q += 2)
+			{
+				// reverse the order of the pairs p..q, each pair keeps its direction
+				for(unsigned int i = p, j = q; i < j; i += 2, j -= 2)
+				{
+					swap(A[i], A[j]);
+					swap(A[i+1], A[j+1]);
+				}
+				if( accept(sol, a, a) )
+					return true;
+				for(unsigned int i = p, j = q; i < j; i += 2, j -= 2)
+				{
+					swap(A[i], A[j]);
+					swap(A[i+1], A[j+1]);
+				}
+			}
+		}
+	}
+	return false;
+}
+
+template class LocalSearchKernel<uint16_t, LocalSearch::SMALL_NODES>;
+template class LocalSearchKernel<uint32_t, LocalSearch::SMALL_NODES>;
+template class LocalSearchKernel<double, LocalSearch::SMALL_NODES>;
+template class LocalSearchKernel<uint16_t, LocalSearch::MEDIUM_NODES>;
+template class LocalSearchKernel<uint32_t, LocalSearch::MEDIUM_NODES>;
+template class LocalSearchKernel<double, LocalSearch::MEDIUM_NODES>;
+template class LocalSearchKernel<uint16_t, 0>;
+template class LocalSearchKernel<uint32_t, 0>;
+template class LocalSearchKernel<double, 0>;
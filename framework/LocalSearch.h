@@ -0,0 +1,134 @@
+#ifndef __LOCAL_SEARCH__H__
+#define __LOCAL_SEARCH__H__
+
+#include <random>
+#include <array>
+#include <algorithm>
+#include <stdint.h>
+#include "Instance.h"
+#include "Solution.h"
+#include "PairGraph.h"
+
+using namespace std;
+
+// travel time sums, exact for the integral distance types
+template<typename D> struct DistanceTraits { typedef int64_t Time; };
+template<> struct DistanceTraits<double> { typedef double Time; };
+
+// per-station storage, fixed capacity for the size buckets (N > 0)
+template<typename T, int N> struct NodeArray { typedef array<T, N> Type; };
+template<typename T> struct NodeArray<T, 0> { typedef vector<T> Type; };
+
+class LocalSearchBase
+{
+public:
+	virtual ~LocalSearchBase() {};
+	virtual bool construct( Solution& sol ) = 0;
+	virtual bool repair( Solution& sol ) = 0;
+	virtual void improve( Solution& sol ) = 0;
+	virtual void perturb( Solution& sol, int strength ) = 0;
+};
+
+/**
+ * Construction and moves on a private copy of the travel times stored as D,
+ * instantiated for uint16_t, uint32_t and double (see Instance::getDistanceType).
+ * Narrow types fit more distances into every cache line and let the compiler
+ * unroll the tour evaluation without conversions.
+ *
+ * Instances with at most N stations (including the depot) keep the travel
+ * times and the per-station state in fixed arrays with a constant row
+ * stride, N = 0 is the fallback for any size.
+ */
+template<typename D, int N>
+class LocalSearchKernel : public LocalSearchBase
+{
+private:
+
+	typedef typename DistanceTraits<D>::Time Time;
+
+	Instance& instance;
+	mt19937 rng;
+
+	int n;
+	typename NodeArray<D, N*N>::Type t;	// travel times, row-major with N (or n) columns
+
+	vector<int> supplyNodes;
+	vector<int> demandNodes;	// only the required ones
+	typename NodeArray<char, N>::Type nodeType;	// 'S', 'D' or 0 for the depot and cancelled demand nodes
+	vector<vector<int> > candidates;	// supply nodes worth pairing with each demand node
+	bool restricted;		// candidates come from a pair graph
+
+	// state of the solution currently worked on
+	typename NodeArray<char, N>::Type used;	// station is visited by some tour
+	vector<Time> times;	// travel time of each tour
+
+	D dist( int i, int j ) const { return t[i*(N > 0 ? N : n)+j]; };
+	bool isCandidate( int s, int d ) const;
+	Time routeTime( const vector<int>& route ) const;
+
+	void prepare( Solution& sol );
+	bool accept( Solution& sol, int a, int b );
+	bool insertDemand( Solution& sol, int d );
+
+	// neighbourhoods, each applies the first improving move it finds
+	bool exchangeSupplies( Solution& sol );
+	bool relocatePairs( Solution& sol );
+	bool swapPairs( Solution& sol );
+	bool reversePairs( Solution& sol );
+
+public:
+
+	LocalSearchKernel( Instance& _instance, unsigned int seed, const PairGraph* pairs );
+
+	bool construct( Solution& sol );
+	bool repair( Solution& sol );
+	void improve( Solution& sol );
+	void perturb( Solution& sol, int strength );
+};
+
+/**
+ * Native construction and local search for the TCBVRP.
+ *
+ * Tours are handled as sequences of supply/demand pairs (S D S D ...), so
+ * every move keeps the alternation of supply and demand nodes intact and
+ * only has to check the time limit of the tours it touches.
+ *
+ * The kernel matching the value range of the travel times and the number
+ * of stations is chosen once when the object is created. With a pair graph, demand nodes are only
+ * paired with its candidate supply nodes.
+ */
+class LocalSearch
+{
+private:
+
+	LocalSearchBase* kernel;
+
+	// size buckets of the kernels
+	static const int SMALL_NODES = 32;
+	static const int MEDIUM_NODES = 128;
+
+	template<int N> static LocalSearchBase* createKernel( Instance& instance, unsigned int seed, const PairGraph* pairs );
+
+	LocalSearch( const LocalSearch& );
+	LocalSearch& operator=( const LocalSearch& );
+
+public:
+
+	LocalSearch( Instance& _instance, unsigned int seed = 1, const PairGraph* pairs = 0 );
+	~LocalSearch() { delete kernel; };
+
+	// greedy cheapest insertion of the demand nodes in random order
+	bool construct( Solution& sol ) { return kernel->construct(sol); };
+
+	// turns an arbitrary node sequence per tour (e.g. a rounded LP solution)
+	// into a feasible solution, returns false if that fails
+	bool repair( Solution& sol ) { return kernel->repair(sol); };
+
+	// applies improving moves until a local optimum is reached
+	void improve( Solution& sol ) { kernel->improve(sol); };
+
+	// random feasible relocations and supply exchanges
+	void perturb( Solution& sol, int strength ) { kernel->perturb(sol, strength); };
+};
+
+#endif //__LOCAL_SEARCH__H__
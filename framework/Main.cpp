@@ -1,17 +1,131 @@
 #include <iostream>
+#include <getopt.h>
 #include "Tools.h"
 #include "Instance.h"
 #include "tcbvrp_ILP.h"
+#include "Portfolio.h"
+#include "HeuristicSolver.h"
+#include "Decomposition.h"
+#include "Server.h"
+#include "Checkpoint.h"
+#include "RootProfiler.h"
+#include "ExactSolver.h"
+#include "Oracle.h"
+#include "ScenarioEval.h"
 
 using namespace std;
 
 void usage()
 {
-	cout << "USAGE:\t<program> -f filename -m model \n";
+	cout << "USAGE:\t<program> -f filename -m model [-n] [-w threads] [-t seconds] [-x] [-g] [-d deltafile] [-c file] [-r file]\n";
+	cout << "\t-n\tbuild the model without variable names (saves memory on large instances)\n";
+	cout << "\t-w\tnumber of local search threads injecting solutions into CPLEX (default 0)\n";
+	cout << "\t-t\ttime limit in seconds (default 3600, 60 for heuristic and decompose)\n";
+	cout << "\t-x\tfix arcs to 0 by reduced costs of the root LP and a heuristic upper bound\n";
+	cout << "\t-g\tbuild the formulation on the supply/demand pair graph (not with -d)\n";
+	cout << "\t-d\tapply instance changes after solving and re-solve warm, one per line:\n";
+	cout << "\t\tcancel <node> | add <node> | T <limit> | time <i> <j> <time> | solve [seconds]\n";
+	cout << "\t-c\twrite the best solution and bound to a checkpoint file every minute\n";
+	cout << "\t-r\tresume from a checkpoint file (and keep writing it unless -c is given)\n";
+	cout << "\t\tSIGINT/SIGTERM stop the solver cleanly and print the best solution\n";
+	cout << "\t--build-threads=N\tassemble the large SCF/MCF constraint families on N threads (default 1)\n";
+	cout << "\t-m race[=scf,mcf,mtz]\tsolve the given formulations concurrently, the first proof wins\n";
+	cout << "\t-m heuristic\tnative local search with route pool recombination (-w threads)\n";
+	cout << "\t-m exact\tnative dynamic programming over station subsets, at most 64 stations\n";
+	cout << "\t--exact\tsolve instances up to " << ExactSolver::AUTO_MAX_NODES - 1 << " stations exactly first, the selected engine\n";
+	cout << "\t\tonly runs if the exact solver finds no proof within " << ExactSolver::AUTO_TIME_LIMIT << " seconds\n";
+	cout << "\t-m decompose[=heuristic|scf|mcf|mtz]\tsolve geographic clusters in parallel (-w threads)\n";
+	cout << "\t\tand improve the combined solution by local search, for very large instances\n";
+	cout << "MODELS:\tscf, mcf, mtz, mcf-benders (MCF with the flows as lazy cuts),\n";
+	cout << "\ttflow (single commodity flow of the elapsed tour time)\n";
+	cout << "PROFILE:\t<program> --root-only[=cuts] [-f filename] [-m scf,mcf,mtz,tflow] [-n] [-g] [-t seconds] [--build-threads=N]\n";
+	cout << "\t\tbuild every formulation on every instances/*.prob (or only -f) and report model size,\n";
+	cout << "\t\tbuild time, LP time and LP bound (and root time and bound with cuts) as a table\n";
+	cout << "ORACLE:\t<program> --oracle[=runs] [-m heuristic,scf,mtz] [-g] [-t seconds]\n";
+	cout << "\t\tcheck every engine against the exact solver on random small instances (default 100)\n";
+	cout << "SCENARIOS:\t<program> -f filename --scenarios=file [-w threads] checkpoint...\n";
+	cout << "\t\tscore the solutions of checkpoint files under every distance matrix of the file\n";
+	cout << "\t\t(\"-\" for stdin): cost distribution and probability of tours over T\n";
+	cout << "SERVER:\t<program> -S socket [-p workers]\n";
+	cout << "\t\tsolve requests over a Unix domain socket, see Server.h\n";
 	cout << "EXAMPLE:\t" << "./tcbvrp -f instances/tcbvrp_10_1_T240_m2.prob -m scf \n\n";
 	exit( 1 );
 }
 
+// applies the changes of a delta file to a solved instance, every "solve" line re-solves warm
+void applyDeltas( const string& deltaFile, Instance& instance, tcbvrp_ILP* ilp, HeuristicSolver* heuristic, Checkpoint* checkpoint )
+{
+	ifstream is( deltaFile.c_str() );
+	if( !is.is_open() )
+	{
+		cerr << "Cannot open file " << deltaFile << endl;
+		return;
+	}
+
+	string line;
+	while( getline( is, line ) && !Checkpoint::interrupted() )
+	{
+		stringstream ss( line );
+		string cmd;
+		ss >> cmd;
+		if( cmd.empty() || cmd[0] == '#' )
+			continue;
+
+		cout << "Delta: " << line << "\n";
+		if( cmd == "cancel" || cmd == "add" )
+		{
+			int node;
+			ss >> node;
+			if( ilp )
+				ilp->setNodeCoverage( node, cmd == "add" );
+			else if( instance.isDemandNode( node ) )
+				instance.setRequired( node, cmd == "add" );
+		}
+		else if( cmd == "T" )
+		{
+			int limit;
+			ss >> limit;
+			if( ilp )
+				ilp->setRouteTimeLimit( limit );
+			else
+				instance.T = limit;
+		}
+		else if( cmd == "time" )
+		{
+			int i, j;
+			double time;
+			ss >> i >> j >> time;
+			if( ilp )
+				ilp->setArcTime( i, j, time );
+			else
+				instance.setDistance( i, j, time );
+		}
+		else if( cmd == "solve" )
+		{
+			double seconds;
+			if( ss >> seconds )
+			{
+				if( ilp )
+					ilp->setTimeLimit( seconds );
+				else
+					heuristic->setTimeLimit( seconds );
+			}
+			// solution and bound of the previous instance do not hold any more
+			if( checkpoint )
+				checkpoint->reset();
+			if( ilp )
+				ilp->resolve();
+			else
+			{
+				heuristic->setStartSolution( heuristic->getSolution() );
+				heuristic->solve();
+			}
+		}
+		else
+			cerr << "Unknown delta: " << line << "\n";
+	}
+}
+
 int main( int argc, char *argv[] )
 {
 	// read parameters
@@ -19,25 +133,274 @@ int main( int argc, char *argv[] )
 	// default values
 	string file( "instances/tcbvrp_10_1_T240_m2.prob" );
 	string model_type( "scf" );
-	while( (opt = getopt( argc, argv, "f:m:" )) != EOF ) {
+	bool namedVars = true;
+	int heuristicThreads = 0;
+	double timeLimit = -1;
+	bool reducedCostFixing = false;
+	bool pairGraphReduction = false;
+	string deltaFile;
+	string checkpointFile;
+	string resumeFile;
+	string socketPath;
+	int serverWorkers = 2;
+	bool rootOnly = false;
+	bool rootCuts = false;
+	bool fileGiven = false;
+	bool modelGiven = false;
+	bool autoExact = false;
+	int oracleRuns = 0;
+	string scenarioFile;
+	int buildThreads = 1;
+	static struct option longOptions[] = {
+		{ "root-only", optional_argument, 0, 'R' },
+		{ "exact", no_argument, 0, 'E' },
+		{ "oracle", optional_argument, 0, 'O' },
+		{ "scenarios", required_argument, 0, 'Z' },
+		{ "build-threads", required_argument, 0, 'B' },
+		{ 0, 0, 0, 0 }
+	};
+	while( (opt = getopt_long( argc, argv, "f:m:nw:t:xgd:c:r:S:p:", longOptions, 0 )) != EOF ) {
 		switch( opt ) {
 			case 'f': // instance file
 				file = optarg;
+				fileGiven = true;
 				break;
 			case 'm': // algorithm to use
 				model_type = optarg;
+				modelGiven = true;
+				break;
+			case 'n': // skip variable names
+				namedVars = false;
+				break;
+			case 'w': // heuristic threads
+				heuristicThreads = atoi( optarg );
+				break;
+			case 't': // time limit
+				timeLimit = atof( optarg );
+				break;
+			case 'x': // reduced cost fixing
+				reducedCostFixing = true;
+				break;
+			case 'g': // pair graph reduction
+				pairGraphReduction = true;
+				break;
+			case 'd': // instance changes
+				deltaFile = optarg;
+				break;
+			case 'c': // checkpoint file
+				checkpointFile = optarg;
+				break;
+			case 'r': // resume from checkpoint
+				resumeFile = optarg;
+				break;
+			case 'S': // daemon mode
+				socketPath = optarg;
+				break;
+			case 'p': // server worker threads
+				serverWorkers = atoi( optarg );
+				break;
+			case 'R': // root relaxation profile
+				rootOnly = true;
+				if( optarg && string( optarg ) == "cuts" )
+					rootCuts = true;
+				else if( optarg )
+					usage();
+				break;
+			case 'E': // exact fast path for small instances
+				autoExact = true;
+				break;
+			case 'Z': // travel time scenarios
+				scenarioFile = optarg;
+				break;
+			case 'B': // parallel model construction
+				buildThreads = atoi( optarg );
+				if( buildThreads <= 0 )
+					usage();
+				break;
+			case 'O': // check the engines against the exact solver
+				oracleRuns = optarg ? atoi( optarg ) : 100;
+				if( oracleRuns <= 0 )
+					usage();
 				break;
 			default:
 				usage();
 				break;
 		}
 	}
+	if( !socketPath.empty() )
+	{
+		Server server( socketPath, serverWorkers );
+		return server.run() ? 0 : -1;
+	}
+
+	if( rootOnly )
+	{
+		vector<string> files;
+		if( fileGiven )
+			files.push_back( file );
+		else
+			files = RootProfiler::instanceFiles();
+		vector<string> models;
+		stringstream ss( modelGiven ? model_type : "scf,mcf,mtz,tflow" );
+		string model;
+		while( getline( ss, model, ',' ) )
+			models.push_back( model );
+
+		RootProfiler profiler( files, models, namedVars );
+		profiler.setCuts( rootCuts );
+		profiler.setPairGraphReduction( pairGraphReduction );
+		profiler.setBuildThreads( buildThreads );
+		if( timeLimit > 0 )
+			profiler.setTimeLimit( timeLimit );
+		profiler.run();
+		return 0;
+	}
+
+	if( oracleRuns > 0 )
+	{
+		vector<string> engines;
+		stringstream ss( modelGiven ? model_type : "heuristic,scf,mtz" );
+		string engine;
+		while( getline( ss, engine, ',' ) )
+			engines.push_back( engine );
+
+		Oracle oracle( engines, oracleRuns );
+		oracle.setPairGraphReduction( pairGraphReduction );
+		if( timeLimit > 0 )
+			oracle.setTimeLimit( timeLimit );
+		return oracle.run() ? 0 : -1;
+	}
+
 	// read instance
 	Instance instance( file );
 	// solve instance
 	cout << "Loaded Instance: " << file << endl;
-	tcbvrp_ILP ilp( instance, model_type);
-	ilp.solve();
+	cout << "Resources after instance load: peak RSS " << Tools::peakRSS() << " kB\n";
+
+	if( checkpointFile.empty() )
+		checkpointFile = resumeFile;
+	Checkpoint checkpointStore( checkpointFile );
+	Checkpoint* checkpoint = checkpointFile.empty() ? 0 : &checkpointStore;
+
+	if( !scenarioFile.empty() )
+	{
+		// the solutions to score are the remaining arguments
+		if( optind >= argc )
+			usage();
+		int threads = heuristicThreads > 0 ? heuristicThreads : max(1u, thread::hardware_concurrency());
+		ScenarioEval eval( instance, threads );
+		for(int i = optind; i < argc; i++)
+		{
+			Solution sol;
+			if( !Checkpoint::load( argv[i], instance, sol ) )
+				return -1;
+			eval.addSolution( sol );
+		}
+		bool ok = eval.run( scenarioFile );
+		eval.print( cout );
+		return ok ? 0 : -1;
+	}
+
+	Solution start;
+	bool resume = false;
+	if( !resumeFile.empty() )
+	{
+		resume = Checkpoint::load( resumeFile, instance, start );
+		if( resume )
+			cout << "Resuming from checkpoint " << resumeFile << " with objective " << start.cost << "\n";
+	}
+
+	// with --exact small instances are solved exactly, the selected engine only runs without a proof
+	bool exactOnly = model_type == "exact";
+	if( exactOnly || (autoExact && deltaFile.empty() && instance.n <= ExactSolver::AUTO_MAX_NODES) )
+	{
+		ExactSolver exact( instance );
+		if( exactOnly && timeLimit > 0 )
+			exact.setTimeLimit( timeLimit );
+		else if( !exactOnly )
+			exact.setTimeLimit( timeLimit > 0 ? min( timeLimit, (double)ExactSolver::AUTO_TIME_LIMIT ) : ExactSolver::AUTO_TIME_LIMIT );
+		Checkpoint::onInterrupt( [&exact]() { exact.abort(); } );
+		bool complete = exact.solve();
+		Checkpoint::onInterrupt( function<void()>() );
+		if( checkpoint && exact.hasSolution() )
+			checkpoint->save( exact.getSolution(), complete ? exact.getSolution().cost : -1e30, true );
+		// an interrupt during the exact solve also ends the run, the handler only fires once
+		if( exactOnly || complete || Checkpoint::interrupted() )
+			return exact.hasSolution() ? 0 : -1;
+		cout << "No proof by the exact solver, solving with " << model_type << "\n";
+	}
+
+	if( model_type == "heuristic" )
+	{
+		HeuristicSolver heuristic( instance, heuristicThreads );
+		if( timeLimit > 0 )
+			heuristic.setTimeLimit( timeLimit );
+		heuristic.setCheckpoint( checkpoint );
+		if( resume )
+			heuristic.setStartSolution( start );
+		Checkpoint::onInterrupt( [&heuristic]() { heuristic.abort(); } );
+		bool found = heuristic.solve();
+		if( found && !deltaFile.empty() )
+			applyDeltas( deltaFile, instance, 0, &heuristic, checkpoint );
+		Checkpoint::onInterrupt( function<void()>() );
+		return found ? 0 : -1;
+	}
+
+	if( model_type.compare(0, 9, "decompose") == 0 )
+	{
+		string engine = model_type.size() > 10 ? model_type.substr(10) : "heuristic";
+		int threads = heuristicThreads > 0 ? heuristicThreads : max(1u, thread::hardware_concurrency());
+		Decomposition decomposition( instance, engine, threads );
+		if( timeLimit > 0 )
+			decomposition.setTimeLimit( timeLimit );
+		decomposition.setCheckpoint( checkpoint );
+		Checkpoint::onInterrupt( [&decomposition]() { decomposition.abort(); } );
+		bool found = decomposition.solve();
+		Checkpoint::onInterrupt( function<void()>() );
+		return found ? 0 : -1;
+	}
+
+	if( model_type.compare(0, 4, "race") == 0 )
+	{
+		// formulations to race, separated by commas
+		vector<string> models;
+		string list = model_type.size() > 5 ? model_type.substr(5) : "scf,mcf,mtz";
+		stringstream ss( list );
+		string model;
+		while( getline( ss, model, ',' ) )
+			models.push_back( model );
+
+		Portfolio portfolio( instance, models, namedVars );
+		portfolio.setHeuristicThreads( heuristicThreads );
+		if( timeLimit > 0 )
+			portfolio.setTimeLimit( timeLimit );
+		portfolio.setCheckpoint( checkpoint );
+		if( resume )
+			portfolio.setStartSolution( start );
+		Checkpoint::onInterrupt( [&portfolio]() { portfolio.abort(); } );
+		portfolio.solve();
+		Checkpoint::onInterrupt( function<void()>() );
+		return 0;
+	}
+
+	tcbvrp_ILP ilp( instance, model_type, namedVars);
+	ilp.setHeuristicThreads( heuristicThreads );
+	ilp.setBuildThreads( buildThreads );
+	if( timeLimit > 0 )
+		ilp.setTimeLimit( timeLimit );
+	ilp.setReducedCostFixing( reducedCostFixing );
+	if( pairGraphReduction && !deltaFile.empty() )
+		cerr << "The pair graph is built for the loaded instance only, ignoring -g with -d\n";
+	else
+		ilp.setPairGraphReduction( pairGraphReduction );
+	ilp.setCheckpoint( checkpoint, resume );
+	if( resume )
+		ilp.setStartSolution( start );
+	Checkpoint::onInterrupt( [&ilp]() { ilp.abort(); } );
+	bool solved = ilp.solve();
+	if( solved && !deltaFile.empty() )
+		applyDeltas( deltaFile, instance, &ilp, 0, checkpoint );
+	Checkpoint::onInterrupt( function<void()>() );
 
-	return 0;
+	return solved ? 0 : -1;
 }
@@ -0,0 +1,45 @@
+#include "MaxFlow.h"
+
+// capacities below EPS are treated as 0
+static const double EPS = 1e-9;
+
+double MaxFlow::solve( int source, int sink, double limit )
+{
+	double flow = 0;
+	while( flow < limit - EPS && findPath(source, sink) )
+	{
+		double bottleneck = limit - flow;
+		for(int v = sink; v != source; v = parent[v])
+			bottleneck = min(bottleneck, capacity[parent[v]*n + v]);
+		for(int v = sink; v != source; v = parent[v])
+		{
+			capacity[parent[v]*n + v] -= bottleneck;
+			capacity[v*n + parent[v]] += bottleneck;
+		}
+		flow += bottleneck;
+	}
+	return flow;
+}
+
+bool MaxFlow::findPath( int source, int sink )
+{
+	parent.assign(n, -1);
+	parent[source] = source;
+	deque<int> queue(1, source);
+	while( !queue.empty() )
+	{
+		int u = queue.front();
+		queue.pop_front();
+		for(int v = 0; v < n; v++)
+		{
+			if( parent[v] < 0 && capacity[u*n + v] > EPS )
+			{
+				parent[v] = u;
+				if( v == sink )
+					return true;
+				queue.push_back(v);
+			}
+		}
+	}
+	return false;
+}
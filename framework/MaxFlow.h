@@ -0,0 +1,38 @@
+#ifndef __MAX_FLOW__H__
+#define __MAX_FLOW__H__
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Maximum flow on a small dense directed graph (Edmonds-Karp). If solve()
+ * stops below its limit, the nodes reachable from the source in the residual
+ * graph form a minimum cut.
+ */
+class MaxFlow
+{
+private:
+
+	int n;
+	vector<double> capacity;	// residual capacities, row-major n x n
+	vector<int> parent;
+
+	bool findPath( int source, int sink );
+
+public:
+
+	MaxFlow( int _n ) : n( _n ), capacity( _n * _n, 0 ), parent( _n ) {};
+
+	void setCapacity( int i, int j, double c ) { capacity[i*n + j] = c; };
+
+	// augments until the flow reaches limit or no augmenting path is left
+	double solve( int source, int sink, double limit );
+
+	// true if v is on the source side of the minimum cut found by solve()
+	bool isSourceSide( int v ) { return parent[v] >= 0; };
+};
+
+#endif //__MAX_FLOW__H__
@@ -0,0 +1,188 @@
+#include "Oracle.h"
+#include "HeuristicSolver.h"
+#include "tcbvrp_ILP.h"
+
+// objectives within CPLEX's default optimality tolerances (EpGap, EpAGap) are equal
+static const double REL_TOLERANCE = 1e-4;
+static const double ABS_TOLERANCE = 1e-6;
+// seconds, the heuristic always runs until its time limit
+static const double HEURISTIC_TIME = 2;
+
+static double tolerance( double optimum )
+{
+	return max( REL_TOLERANCE * fabs( optimum ), ABS_TOLERANCE );
+}
+
+Oracle::Oracle( const vector<string>& _engines, int _runs, unsigned int _seed ) :
+engines( _engines ), runs( _runs ), seed( _seed ), timeLimit( 60 ), pairGraphReduction( false )
+{
+}
+
+bool Oracle::run()
+{
+	mt19937 rng( seed );
+	int failures = 0;
+	int infeasible = 0;
+
+	for(int r = 0; r < runs && !Checkpoint::interrupted(); r++)
+	{
+		string text = randomInstance( rng );
+		stringstream is( text );
+		Instance instance;
+		instance.read( is );
+
+		ExactSolver exact( instance );
+		if( !exact.solve( true ) )
+		{
+			cout << "Run " << r << ": exact solver gave up, skipped\n";
+			continue;
+		}
+		if( !exact.hasSolution() )
+			infeasible++;
+
+		cout << "Run " << r << ": " << instance.n - 1 << " stations, T " << instance.T << ", m " << instance.m << ", ";
+		if( exact.hasSolution() )
+			cout << "optimum " << exact.getSolution().cost << "\n";
+		else
+			cout << "infeasible\n";
+
+		bool ok = true;
+		for(unsigned int e = 0; e < engines.size(); e++)
+		{
+			string message;
+			if( !check( engines[e], instance, exact, message ) )
+				ok = false;
+			if( !message.empty() )
+				cout << "\t" << engines[e] << ": " << message << "\n";
+		}
+		if( ok )
+			continue;
+
+		failures++;
+		stringstream name;
+		name << "oracle_" << r << ".prob";
+		ofstream os( name.str().c_str() );
+		os << text;
+		cout << "\tinstance written to " << name.str() << "\n";
+	}
+
+	cout << "Oracle: " << runs << " instances (" << infeasible << " infeasible), "
+		<< failures << " with wrong answers\n";
+	return failures == 0;
+}
+
+// ----- private methods -----
+
+string Oracle::randomInstance( mt19937& rng )
+{
+	// between 2 and 6 demand nodes and about as many supply nodes
+	int demands = uniform_int_distribution<int>( 2, 6 )( rng );
+	int supplies = max( 1, demands + uniform_int_distribution<int>( -1, 2 )( rng ) );
+	int stations = demands + supplies;
+	int vehicles = uniform_int_distribution<int>( 1, 3 )( rng );
+
+	vector<char> type( stations, 'S' );
+	fill( type.begin(), type.begin() + demands, 'D' );
+	shuffle( type.begin(), type.end(), rng );
+
+	// points in the plane, the depot is node 0
+	uniform_real_distribution<double> coord( 0, 100 );
+	vector<double> x( stations + 1 ), y( stations + 1 );
+	for(int i = 0; i <= stations; i++)
+	{
+		x[i] = coord( rng );
+		y[i] = coord( rng );
+	}
+
+	// travel times are rounded up distances, never zero between two nodes
+	vector<vector<int> > t( stations + 1, vector<int>( stations + 1, 0 ) );
+	int farthest = 0;
+	for(int i = 0; i <= stations; i++)
+	{
+		for(int j = 0; j <= stations; j++)
+		{
+			if( i != j )
+				t[i][j] = (int)ceil( sqrt( (x[i]-x[j])*(x[i]-x[j]) + (y[i]-y[j])*(y[i]-y[j]) ) ) + 1;
+		}
+		farthest = max( farthest, t[0][i] );
+	}
+	// from too tight for some stations to a few pairs per tour
+	int limit = (int)( farthest * uniform_real_distribution<double>( 2.2, 6 )( rng ) );
+
+	stringstream os;
+	os << stations << "\n" << limit << "\n" << vehicles << "\n";
+	for(int i = 1; i <= stations; i++)
+		os << i << " " << type[i-1] << "\n";
+	for(int i = 0; i <= stations; i++)
+	{
+		for(int j = 0; j <= stations; j++)
+			os << t[i][j] << " ";
+		os << "\n";
+	}
+	return os.str();
+}
+
+bool Oracle::check( const string& engine, Instance& instance, ExactSolver& exact, string& message )
+{
+	stringstream ss;
+	bool feasible = exact.hasSolution();
+	double optimum = feasible ? exact.getSolution().cost : 0;
+
+	if( engine == "heuristic" )
+	{
+		HeuristicSolver heuristic( instance, 1 );
+		heuristic.setTimeLimit( min( timeLimit, HEURISTIC_TIME ) );
+		heuristic.setRecombineInterval( HEURISTIC_TIME / 4 );
+		bool found = heuristic.solve( true );
+		if( found && !feasible )
+			ss << "solution of an infeasible instance";
+		else if( found && !heuristic.getSolution().isFeasible( instance ) )
+			ss << "infeasible solution";
+		else if( found && heuristic.getSolution().cost < optimum - tolerance( optimum ) )
+			ss << "objective " << heuristic.getSolution().cost << " below the optimum";
+		else
+		{
+			// not finding the optimum is no error of a heuristic
+			if( found && heuristic.getSolution().cost > optimum + tolerance( optimum ) )
+				message = "gap " + to_string( heuristic.getSolution().cost - optimum );
+			else if( !found && feasible )
+				message = "no solution";
+			return true;
+		}
+		message = ss.str();
+		return false;
+	}
+
+	tcbvrp_ILP ilp( instance, engine, false );
+	ilp.setQuiet( true );
+	ilp.setTimeLimit( timeLimit );
+	ilp.setPairGraphReduction( pairGraphReduction );
+	ilp.solve();
+	const tcbvrp_ILP::Result& result = ilp.getResult();
+
+	// any solution is checked, also the ones of runs stopped by the time limit
+	if( result.hasSolution && !feasible )
+		ss << "solution of an infeasible instance";
+	else if( result.hasSolution && !result.solution.isFeasible( instance ) )
+		ss << "infeasible solution";
+	else if( result.status == IloAlgorithm::Optimal )
+	{
+		if( fabs( result.objValue - optimum ) > tolerance( optimum ) )
+			ss << "objective " << result.objValue << " instead of " << optimum;
+	}
+	else if( result.status == IloAlgorithm::Infeasible )
+	{
+		if( feasible )
+			ss << "infeasible instead of " << optimum;
+	}
+	else if( result.hasSolution && feasible && result.objValue < optimum - tolerance( optimum ) )
+		ss << "objective " << result.objValue << " below the optimum";
+	else
+	{
+		ss << "status " << result.status;
+		message = ss.str();
+		return true;
+	}
+	message = ss.str();
+	return message.empty();
+}
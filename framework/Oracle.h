@@ -0,0 +1,47 @@
+#ifndef __ORACLE__H__
+#define __ORACLE__H__
+
+#include <random>
+#include "Tools.h"
+#include "Instance.h"
+#include "Solution.h"
+#include "ExactSolver.h"
+#include "Checkpoint.h"
+
+using namespace std;
+
+/**
+ * Correctness check of the engines against the exact solver on random small
+ * instances: the formulations have to reach the optimum whenever CPLEX
+ * claims optimality (or infeasibility), the heuristic must return a feasible
+ * solution which is not better than the optimum. Instances on which an engine
+ * fails are written to oracle_<run>.prob.
+ */
+class Oracle
+{
+private:
+
+	vector<string> engines;
+	int runs;
+	unsigned int seed;
+	double timeLimit;	// per engine and instance
+	bool pairGraphReduction;
+
+	// random instance with up to 12 stations in the file format of Instance::read
+	string randomInstance( mt19937& rng );
+
+	// returns false on a wrong answer of the engine
+	bool check( const string& engine, Instance& instance, ExactSolver& exact, string& message );
+
+public:
+
+	Oracle( const vector<string>& _engines, int _runs, unsigned int _seed = 1 );
+
+	void setTimeLimit( double seconds ) { timeLimit = seconds; };
+	void setPairGraphReduction( bool enable ) { pairGraphReduction = enable; };
+
+	// returns true if every engine agreed with the exact solver on every instance
+	bool run();
+};
+
+#endif //__ORACLE__H__
@@ -0,0 +1,116 @@
+#include "PairGraph.h"
+
+PairGraph::PairGraph( Instance& instance ) :
+n( instance.n ), supplies( instance.n ), arcs( instance.n * instance.n, 0 ), numArcs( 0 ), numInfeasible( 0 ), numDominated( 0 )
+{
+	const vector<int>& supplyNodes = instance.getSupplyNodes();
+	vector<int> demandNodes;
+	for(unsigned int i = 0; i < instance.getDemandNodes().size(); i++)
+	{
+		if( instance.isRequired(instance.getDemandNodes()[i]) )
+			demandNodes.push_back(instance.getDemandNodes()[i]);
+	}
+	int numDemands = demandNodes.size();
+
+	/*
+	 * pairs which fit into a tour of their own, dominance among them
+	 */
+
+	for(int a = 0; a < numDemands; a++)
+	{
+		int d = demandNodes[a];
+		vector<int> feasible;
+		for(unsigned int i = 0; i < supplyNodes.size(); i++)
+		{
+			int s = supplyNodes[i];
+			if( instance.getDistance(0, s) + instance.getDistance(s, d) + instance.getDistance(d, 0) <= instance.T )
+				feasible.push_back(s);
+			else
+				numInfeasible++;
+		}
+
+		// way from every possible predecessor (depot or another demand node) over s to d
+		vector<vector<double> > way( feasible.size(), vector<double>(numDemands) );
+		for(unsigned int i = 0; i < feasible.size(); i++)
+		{
+			for(int b = 0; b < numDemands; b++)
+			{
+				int p = b == a ? 0 : demandNodes[b];
+				way[i][b] = instance.getDistance(p, feasible[i]) + instance.getDistance(feasible[i], d);
+			}
+		}
+
+		for(unsigned int i = 0; i < feasible.size(); i++)
+		{
+			int dominators = 0;
+			for(unsigned int j = 0; j < feasible.size() && dominators < numDemands; j++)
+			{
+				if( i == j )
+					continue;
+				bool dominates = true, equal = true;
+				for(int b = 0; b < numDemands && dominates; b++)
+				{
+					dominates = way[j][b] <= way[i][b];
+					equal = equal && way[j][b] == way[i][b];
+				}
+				// ties are broken by the node number to keep the relation acyclic
+				if( dominates && (!equal || feasible[j] < feasible[i]) )
+					dominators++;
+			}
+			if( dominators >= numDemands )
+			{
+				numDominated++;
+				continue;
+			}
+
+			Pair pair;
+			pair.s = feasible[i];
+			pair.d = d;
+			pair.cost = instance.getDistance(pair.s, d);
+			pairs.push_back(pair);
+			supplies[d].push_back(pair.s);
+		}
+	}
+
+	/*
+	 * shortest way from the depot to the end of a pair and from the start of
+	 * a pair back to the depot, arcs between pairs have to fit in between
+	 */
+
+	vector<double> toEnd( n, 1e30 ), fromStart( n, 1e30 );
+	for(unsigned int p = 0; p < pairs.size(); p++)
+	{
+		int s = pairs[p].s, d = pairs[p].d;
+		toEnd[d] = min(toEnd[d], instance.getDistance(0, s) + pairs[p].cost);
+		fromStart[s] = min(fromStart[s], pairs[p].cost + instance.getDistance(d, 0));
+		arcs[s*n + d] = 1;
+	}
+
+	for(int v = 1; v < n; v++)
+	{
+		if( fromStart[v] < 1e30 )
+			arcs[v] = 1;
+		if( toEnd[v] < 1e30 )
+			arcs[v*n] = 1;
+	}
+
+	for(int d = 1; d < n; d++)
+	{
+		if( toEnd[d] >= 1e30 )
+			continue;
+		for(int s = 1; s < n; s++)
+		{
+			if( fromStart[s] < 1e30 && toEnd[d] + instance.getDistance(d, s) + fromStart[s] <= instance.T )
+				arcs[d*n + s] = 1;
+		}
+	}
+
+	for(unsigned int i = 0; i < arcs.size(); i++)
+		numArcs += arcs[i];
+}
+
+void PairGraph::print( ostream& os ) const
+{
+	os << "Pair graph: " << pairs.size() << " pairs (" << numInfeasible << " exceeding the time limit, "
+		<< numDominated << " dominated), " << numArcs << " of " << n * n << " arcs\n";
+}
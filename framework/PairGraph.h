@@ -0,0 +1,55 @@
+#ifndef __PAIR_GRAPH__H__
+#define __PAIR_GRAPH__H__
+
+#include <vector>
+#include "Instance.h"
+
+using namespace std;
+
+/**
+ * Reduced graph of supply/demand pairs. Every tour is depot, S D, S D, ...,
+ * depot, so only the arcs depot->S, S->D (a pair), D->S and D->depot can be
+ * used at all. On top of that the graph drops
+ *
+ *  - pairs and arcs which cannot be part of any tour within the time limit
+ *  - pairs (s,d) for which at least as many other supply nodes dominate s as
+ *    there are demand nodes: s' dominates s for d if the way from any
+ *    predecessor over s' to d is not longer than over s. One of the
+ *    dominating supply nodes is always left unused by the other demand
+ *    nodes and can replace s, so an optimal solution survives.
+ *
+ * Only the required demand nodes get pairs, the graph has to be rebuilt if
+ * the instance changes.
+ */
+class PairGraph
+{
+public:
+
+	struct Pair
+	{
+		int s, d;
+		double cost;	// travel time from s to d
+	};
+
+private:
+
+	int n;
+	vector<Pair> pairs;
+	vector<vector<int> > supplies;	// candidate supply nodes of each demand node
+	vector<char> arcs;				// row-major n x n
+	int numArcs;
+	int numInfeasible;				// pairs exceeding the time limit on their own
+	int numDominated;
+
+public:
+
+	PairGraph( Instance& instance );
+
+	bool hasArc( int i, int j ) const { return arcs[i*n + j] != 0; };
+	const vector<Pair>& getPairs() const { return pairs; };
+	const vector<int>& getSupplies( int d ) const { return supplies[d]; };
+
+	void print( ostream& os ) const;
+};
+
+#endif //__PAIR_GRAPH__H__
@@ -0,0 +1,119 @@
+#include "Portfolio.h"
+
+Portfolio::Portfolio( Instance& _instance, const vector<string>& _models, bool _namedVars ) :
+instance( _instance ), models( _models ), namedVars( _namedVars ), heuristicThreads( 0 ), timeLimit( 3600 ), winner( -1 ), aborted( false ), checkpoint( 0 ), hasStart( false )
+{
+}
+
+Portfolio::~Portfolio()
+{
+	for(unsigned int i = 0; i < solvers.size(); i++)
+		delete solvers[i];
+}
+
+void Portfolio::solve()
+{
+	SolutionPool pool;
+	if( hasStart )
+		pool.offer( start );
+	ConcurrentHeuristic* heuristic = 0;
+	if( heuristicThreads > 0 )
+		heuristic = new ConcurrentHeuristic( instance, pool, heuristicThreads );
+
+	for(unsigned int i = 0; i < models.size(); i++)
+	{
+		tcbvrp_ILP* ilp = new tcbvrp_ILP( instance, models[i], namedVars );
+		ilp->setQuiet( true );
+		ilp->setTimeLimit( timeLimit );
+		ilp->shareSolutions( &pool, heuristic );
+		ilp->setCheckpoint( checkpoint );
+
+		lock_guard<mutex> guard(lock);
+		if( aborted )
+			ilp->abort();
+		solvers.push_back( ilp );
+	}
+
+	cout << "Racing " << models.size() << " formulations ...\n";
+	vector<thread> threads;
+	for(unsigned int i = 0; i < solvers.size(); i++)
+		threads.push_back(thread(&Portfolio::run, this, i));
+	for(unsigned int i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	if( heuristic )
+	{
+		heuristic->stop();
+		delete heuristic;
+	}
+
+	/*
+	 * without a proof (time limit) the solver with the best incumbent wins
+	 */
+
+	int best = winner;
+	for(unsigned int i = 0; winner < 0 && i < solvers.size(); i++)
+	{
+		const tcbvrp_ILP::Result& result = solvers[i]->getResult();
+		if( result.hasSolution && (best < 0 || result.objValue < solvers[best]->getResult().objValue) )
+			best = i;
+	}
+
+	for(unsigned int i = 0; i < solvers.size(); i++)
+	{
+		const tcbvrp_ILP::Result& result = solvers[i]->getResult();
+		cout << "Model " << solvers[i]->getModelType() << ": status " << result.status
+			<< ", nodes " << result.nodes << ", bound " << result.bound;
+		if( result.hasSolution )
+			cout << ", objective " << result.objValue;
+		cout << ", time " << result.time << " s\n";
+	}
+	cout << "\n";
+
+	if( best < 0 )
+	{
+		cout << "CPLEX status: Unknown\n";
+		cout << "No formulation found a solution.\n";
+		return;
+	}
+
+	const tcbvrp_ILP::Result& result = solvers[best]->getResult();
+	cout << "Used Model: " << solvers[best]->getModelType() << (winner >= 0 ? " (proof)" : " (best incumbent)") << "\n";
+	cout << "CPLEX status: " << result.status << "\n";
+	cout << "Branch-and-Bound nodes: " << result.nodes << "\n";
+	if( result.hasSolution )
+		cout << "Objective value: " << result.objValue << "\n";
+	cout << "Wall time: " << result.time << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+	if( result.hasSolution )
+		result.solution.print( cout );
+}
+
+void Portfolio::abort()
+{
+	lock_guard<mutex> guard(lock);
+	aborted = true;
+	for(unsigned int i = 0; i < solvers.size(); i++)
+		solvers[i]->abort();
+}
+
+// ----- private methods -----------------------------------------------
+
+void Portfolio::run( unsigned int i )
+{
+	solvers[i]->solve();
+
+	IloAlgorithm::Status status = solvers[i]->getResult().status;
+	if( status != IloAlgorithm::Optimal && status != IloAlgorithm::Infeasible )
+		return;
+
+	lock_guard<mutex> guard(lock);
+	if( winner >= 0 )
+		return;
+	winner = i;
+	for(unsigned int j = 0; j < solvers.size(); j++)
+	{
+		if( j != i )
+			solvers[j]->abort();
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef __PORTFOLIO__H__
+#define __PORTFOLIO__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "tcbvrp_ILP.h"
+#include "Checkpoint.h"
+
+using namespace std;
+
+/**
+ * Races several formulations on the same instance. Every formulation is
+ * solved in its own IloEnv on its own thread, incumbents are shared through
+ * a common solution pool and all solvers stop as soon as one of them has
+ * proven optimality (or infeasibility).
+ */
+class Portfolio
+{
+private:
+
+	Instance& instance;
+	vector<string> models;
+	bool namedVars;
+	int heuristicThreads;
+	double timeLimit;
+
+	vector<tcbvrp_ILP*> solvers;
+	mutex lock;
+	int winner; // index of the first solver that finished with a proof
+	bool aborted;
+
+	Checkpoint* checkpoint;
+	Solution start;
+	bool hasStart;
+
+	void run( unsigned int i );
+
+public:
+
+	Portfolio( Instance& _instance, const vector<string>& _models, bool _namedVars = true );
+	~Portfolio();
+
+	void setHeuristicThreads( int threads ) { heuristicThreads = threads; };
+	void setTimeLimit( double seconds ) { timeLimit = seconds; };
+	void setCheckpoint( Checkpoint* _checkpoint ) { checkpoint = _checkpoint; };
+	void setStartSolution( const Solution& sol ) { start = sol; hasStart = true; };
+	void solve();
+
+	// stops all formulations, thread-safe
+	void abort();
+};
+
+#endif //__PORTFOLIO__H__
@@ -0,0 +1,82 @@
+#include "RootProfiler.h"
+#include <glob.h>
+#include <iomanip>
+
+RootProfiler::RootProfiler( const vector<string>& _files, const vector<string>& _models, bool _namedVars ) :
+files( _files ), models( _models ), namedVars( _namedVars ), withCuts( false ), pairGraphReduction( false ), buildThreads( 1 ), timeLimit( 3600 )
+{
+}
+
+vector<string> RootProfiler::instanceFiles( const string& pattern )
+{
+	vector<string> found;
+	glob_t matches;
+	if( glob( pattern.c_str(), 0, 0, &matches ) == 0 )
+	{
+		for(size_t i = 0; i < matches.gl_pathc; i++)
+			found.push_back( matches.gl_pathv[i] );
+	}
+	globfree( &matches );
+	return found;
+}
+
+void RootProfiler::run()
+{
+	printHeader();
+	for(unsigned int f = 0; f < files.size(); f++)
+	{
+		Instance instance( files[f] );
+		for(unsigned int m = 0; m < models.size(); m++)
+		{
+			// a fresh environment per formulation, so every build starts from scratch
+			tcbvrp_ILP* ilp = new tcbvrp_ILP( instance, models[m], namedVars );
+			ilp->setQuiet( true );
+			ilp->setTimeLimit( timeLimit );
+			ilp->setPairGraphReduction( pairGraphReduction );
+			ilp->setBuildThreads( buildThreads );
+			bool ok = ilp->solveRoot( withCuts );
+			printRow( files[f], models[m], ilp->getRootResult(), ok );
+			delete ilp;
+		}
+	}
+}
+
+// ----- private methods -----
+
+void RootProfiler::printHeader()
+{
+	cout << left << setw(36) << "instance" << setw(12) << "model" << right
+		<< setw(10) << "rows" << setw(10) << "cols" << setw(12) << "nonzeros"
+		<< setw(10) << "build[s]" << setw(10) << "LP[s]" << setw(12) << "LP bound";
+	if( withCuts )
+		cout << setw(10) << "root[s]" << setw(12) << "root bound";
+	cout << "\n";
+}
+
+void RootProfiler::printRow( const string& file, const string& model, const tcbvrp_ILP::RootResult& root, bool ok )
+{
+	string name = file.substr( file.find_last_of( '/' ) + 1 );
+	cout << left << setw(36) << name << setw(12) << model << right;
+	if( !ok )
+	{
+		cout << "  failed\n";
+		return;
+	}
+	cout << setw(10) << root.rows << setw(10) << root.cols << setw(12) << root.nonzeros
+		<< fixed << setprecision(2) << setw(10) << root.buildTime << setw(10) << root.lpTime;
+	if( root.lpStatus == IloAlgorithm::Optimal )
+		cout << setw(12) << root.lpBound;
+	else
+		cout << setw(12) << root.lpStatus;
+	if( withCuts )
+	{
+		cout << setw(10) << root.rootTime;
+		if( root.hasRootBound )
+			cout << setw(12) << root.rootBound;
+		else
+			cout << setw(12) << "-";
+	}
+	cout << "\n";
+	cout.unsetf( ios::fixed );
+	cout << setprecision(6);
+}
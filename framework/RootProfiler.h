@@ -0,0 +1,45 @@
+#ifndef __ROOT_PROFILER__H__
+#define __ROOT_PROFILER__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "tcbvrp_ILP.h"
+
+using namespace std;
+
+/**
+ * Compares the formulations by their root node only. For every instance and
+ * every formulation the model is built and its LP relaxation (and optionally
+ * the root node with cuts) solved, one table row per pair reports model size,
+ * build and solve times and the bounds.
+ */
+class RootProfiler
+{
+private:
+
+	vector<string> files;
+	vector<string> models;
+	bool namedVars;
+	bool withCuts;
+	bool pairGraphReduction;
+	int buildThreads;
+	double timeLimit;
+
+	void printHeader();
+	void printRow( const string& file, const string& model, const tcbvrp_ILP::RootResult& root, bool ok );
+
+public:
+
+	RootProfiler( const vector<string>& _files, const vector<string>& _models, bool _namedVars = true );
+
+	void setCuts( bool enable ) { withCuts = enable; };
+	void setPairGraphReduction( bool enable ) { pairGraphReduction = enable; };
+	void setBuildThreads( int threads ) { buildThreads = threads; };
+	void setTimeLimit( double seconds ) { timeLimit = seconds; };
+	void run();
+
+	// all instances/*.prob in name order
+	static vector<string> instanceFiles( const string& pattern = "instances/*.prob" );
+};
+
+#endif //__ROOT_PROFILER__H__
@@ -0,0 +1,171 @@
+#include "RoutePool.h"
+#include <ilcplex/ilocplex.h>
+
+ILOSTLBEGIN
+
+vector<int> RoutePool::demandSet( const vector<int>& route )
+{
+	// demand nodes are at the odd positions of a tour
+	vector<int> demands;
+	for(unsigned int i = 1; i < route.size(); i += 2)
+		demands.push_back(route[i]);
+	sort(demands.begin(), demands.end());
+	return demands;
+}
+
+size_t RoutePool::DemandHash::operator()( const vector<int>& demands ) const
+{
+	// FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
+	for(unsigned int i = 0; i < demands.size(); i++)
+	{
+		hash ^= (unsigned long long) demands[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+void RoutePool::add( Instance& instance, const Solution& sol )
+{
+	lock_guard<mutex> guard(lock);
+	for(unsigned int r = 0; r < sol.routes.size(); r++)
+	{
+		const vector<int>& route = sol.routes[r];
+		if( route.empty() )
+			continue;
+
+		double time = Solution::routeTime(instance, route);
+		vector<int> demands = demandSet(route);
+		Index::iterator it = index.find(demands);
+		if( it == index.end() )
+		{
+			if( entries.size() >= capacity )
+				continue;
+			Entry entry;
+			entry.route = route;
+			entry.time = time;
+			index[demands] = entries.size();
+			entries.push_back(entry);
+		}
+		else if( time < entries[it->second].time )
+		{
+			entries[it->second].route = route;
+			entries[it->second].time = time;
+		}
+	}
+}
+
+unsigned int RoutePool::size()
+{
+	lock_guard<mutex> guard(lock);
+	return entries.size();
+}
+
+bool RoutePool::recombine( Instance& instance, Solution& sol, double timeLimit )
+{
+	vector<Entry> routes;
+	Index routeIndex;
+	{
+		lock_guard<mutex> guard(lock);
+		routes = entries;
+		routeIndex = index;
+	}
+	if( routes.empty() )
+		return false;
+
+	IloEnv env;
+	bool improved = false;
+	try {
+		IloModel model(env);
+
+		/*
+		 * x(r) is 1 if tour r of the pool is selected
+		 */
+
+		IloBoolVarArray x(env, routes.size());
+		IloExpr objFunction(env);
+		IloExpr numToursExpr(env);
+		vector<IloExpr> coverExpr(instance.n);
+		for(int v = 0; v < instance.n; v++)
+			coverExpr[v] = IloExpr(env);
+
+		for(unsigned int r = 0; r < routes.size(); r++)
+		{
+			objFunction += routes[r].time * x[r];
+			numToursExpr += x[r];
+			for(unsigned int i = 0; i < routes[r].route.size(); i++)
+				coverExpr[routes[r].route[i]] += x[r];
+		}
+		model.add(IloMinimize(env, objFunction));
+		objFunction.end();
+
+		/*
+		 * at most m tours, every required demand node exactly once, cancelled demand
+		 * nodes not at all (pool tours may predate the cancellation), every supply
+		 * node at most once
+		 */
+
+		model.add(numToursExpr <= instance.m);
+		numToursExpr.end();
+		for(int v = 1; v < instance.n; v++)
+		{
+			if( instance.isDemandNode(v) )
+				model.add(coverExpr[v] == (instance.isRequired(v) ? 1 : 0));
+			else
+				model.add(coverExpr[v] <= 1);
+			coverExpr[v].end();
+		}
+		coverExpr[0].end();
+
+		IloCplex cplex(model);
+		cplex.setOut(env.getNullStream());
+		cplex.setWarning(env.getNullStream());
+		cplex.setParam(IloCplex::Threads, 1);
+		cplex.setParam(IloCplex::TiLim, timeLimit);
+
+		// the given solution is a start if all of its tours are in the pool
+		IloNumArray start(env, routes.size());
+		bool complete = !sol.routes.empty();
+		for(unsigned int r = 0; r < sol.routes.size() && complete; r++)
+		{
+			if( sol.routes[r].empty() )
+				continue;
+			Index::iterator it = routeIndex.find(demandSet(sol.routes[r]));
+			if( it == routeIndex.end() )
+				complete = false;
+			else
+				start[it->second] = 1;
+		}
+		if( complete )
+			cplex.addMIPStart(x, start);
+		start.end();
+
+		cplex.solve();
+		if( cplex.getStatus() == IloAlgorithm::Feasible || cplex.getStatus() == IloAlgorithm::Optimal )
+		{
+			double bestCost = sol.routes.empty() ? IloInfinity : sol.evaluate(instance);
+			if( cplex.getObjValue() < bestCost - 1e-6 )
+			{
+				IloNumArray values(env);
+				cplex.getValues(values, x);
+				Solution combined;
+				for(unsigned int r = 0; r < routes.size(); r++)
+				{
+					if( values[r] > 0.5 )
+						combined.routes.push_back(routes[r].route);
+				}
+				combined.evaluate(instance);
+				if( combined.isFeasible(instance) )
+				{
+					sol = combined;
+					improved = true;
+				}
+			}
+		}
+	}
+	catch( IloException& e ) {
+		cerr << "RoutePool: exception " << e << "\n";
+	}
+	env.end();
+	return improved;
+}
@@ -0,0 +1,56 @@
+#ifndef __ROUTE_POOL__H__
+#define __ROUTE_POOL__H__
+
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include "Instance.h"
+#include "Solution.h"
+
+using namespace std;
+
+/**
+ * Collects the tours of heuristic solutions. Tours are deduplicated by their
+ * set of demand nodes and only the cheapest tour per set is kept. The pool is
+ * recombined by a set-partitioning MIP selecting at most m tours which cover
+ * every required demand node exactly once and use every supply node at most once.
+ */
+class RoutePool
+{
+private:
+
+	struct Entry
+	{
+		vector<int> route;
+		double time;
+	};
+
+	// FNV-1a of a demand set, equal hashes are told apart by comparing the sets
+	struct DemandHash
+	{
+		size_t operator()( const vector<int>& demands ) const;
+	};
+	typedef unordered_map<vector<int>, unsigned int, DemandHash> Index;
+
+	mutex lock;
+	vector<Entry> entries;
+	Index index; // sorted demand nodes of a tour -> entry
+	unsigned int capacity;
+
+	static vector<int> demandSet( const vector<int>& route );
+
+public:
+
+	RoutePool( unsigned int _capacity = 200000 ) : capacity( _capacity ) {};
+
+	// adds all tours of a feasible solution
+	void add( Instance& instance, const Solution& sol );
+
+	unsigned int size();
+
+	// solves the set-partitioning problem over the pool, sol is used as start
+	// solution and replaced if a better combination is found
+	bool recombine( Instance& instance, Solution& sol, double timeLimit );
+};
+
+#endif //__ROUTE_POOL__H__
@@ -0,0 +1,61 @@
+#include "RowAssembler.h"
+
+void RowAssembler::Rows::begin( double lower, double upper )
+{
+	lb.push_back( lower );
+	ub.push_back( upper );
+	beg.push_back( ind.size() );
+}
+
+void RowAssembler::Rows::end()
+{
+	// sort the terms of the current row by column and add up duplicates
+	long first = beg.back();
+	long last = ind.size();
+	if( !is_sorted( ind.begin() + first, ind.end() ) )
+	{
+		terms.clear();
+		for(long i = first; i < last; i++)
+			terms.push_back( make_pair( ind[i], val[i] ) );
+		sort( terms.begin(), terms.end() );
+		for(long i = first; i < last; i++)
+		{
+			ind[i] = terms[i - first].first;
+			val[i] = terms[i - first].second;
+		}
+	}
+	long out = first;
+	for(long i = first; i < last; i++)
+	{
+		if( out > first && ind[out-1] == ind[i] )
+			val[out-1] += val[i];
+		else
+		{
+			ind[out] = ind[i];
+			val[out] = val[i];
+			out++;
+		}
+	}
+	ind.resize( out );
+	val.resize( out );
+}
+
+vector<RowAssembler::Rows> RowAssembler::assemble( long count, const Family& family )
+{
+	int chunks = (int)min( (long)threads, max(count, 1L) );
+	vector<Rows> rows( chunks );
+	vector<thread> workers;
+	for(int c = 0; c < chunks; c++)
+	{
+		long first = count * c / chunks;
+		long last = count * (c + 1) / chunks;
+		Rows& out = rows[c];
+		workers.push_back( thread( [first, last, &out, &family]() {
+			for(long outer = first; outer < last; outer++)
+				family( outer, out );
+		} ) );
+	}
+	for(unsigned int c = 0; c < workers.size(); c++)
+		workers[c].join();
+	return rows;
+}
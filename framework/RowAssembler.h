@@ -0,0 +1,55 @@
+#ifndef __ROW_ASSEMBLER__H__
+#define __ROW_ASSEMBLER__H__
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Assembles the sparse rows of a constraint family on several threads. A
+ * family is a function appending all rows of one outer loop index, the outer
+ * range is split into one contiguous chunk per thread and the chunks are
+ * returned in order, so the rows come out exactly as a sequential loop would
+ * generate them. No solver objects are touched here, loading the rows into
+ * the model is left to the (single threaded) caller.
+ */
+class RowAssembler
+{
+public:
+
+	// rows in compressed sparse row form
+	struct Rows
+	{
+		vector<double> lb, ub;
+		vector<long> beg;	// first term of every row in ind/val
+		vector<long> ind;	// column ids, their meaning is up to the caller
+		vector<double> val;
+		vector<pair<long, double> > terms;	// scratch space of end()
+
+		void begin( double lower, double upper );
+		void add( long col, double coef ) { ind.push_back( col ); val.push_back( coef ); };
+		// merges duplicate columns of the current row
+		void end();
+
+		size_t size() const { return beg.size(); };
+		long rowEnd( size_t row ) const { return row + 1 < beg.size() ? beg[row + 1] : ind.size(); };
+	};
+
+	typedef function<void( long outer, Rows& rows )> Family;
+
+private:
+
+	int threads;
+
+public:
+
+	RowAssembler( int _threads ) : threads( max(_threads, 1) ) {};
+
+	// rows of the outer indices 0..count-1, one chunk per thread
+	vector<Rows> assemble( long count, const Family& family );
+};
+
+#endif //__ROW_ASSEMBLER__H__
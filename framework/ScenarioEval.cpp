@@ -0,0 +1,279 @@
+#include "ScenarioEval.h"
+
+// relative accuracy of the cost percentiles
+static const double BUCKET_ACCURACY = 0.001;
+static const double GAMMA = (1 + BUCKET_ACCURACY) / (1 - BUCKET_ACCURACY);
+
+ScenarioEval::ScenarioEval( Instance& _instance, int _threads ) :
+instance( _instance ), threads( max(_threads, 1) ), numArcs( 0 ), readerDone( false ), scenarios( 0 )
+{
+}
+
+bool ScenarioEval::run( const string& scenarioFile )
+{
+	ifstream file;
+	istream* is = &cin;
+	if( scenarioFile != "-" )
+	{
+		file.open( scenarioFile.c_str() );
+		if( !file.is_open() )
+		{
+			cerr << "Cannot open file " << scenarioFile << endl;
+			return false;
+		}
+		is = &file;
+	}
+
+	indexArcs();
+	scenarios = 0;
+	readerDone = false;
+	costs.assign(solutions.size(), CostStats());
+	anyLate.assign(solutions.size(), 0);
+	late.clear();
+	tourTime.clear();
+	for(unsigned int i = 0; i < solutions.size(); i++)
+	{
+		late.push_back(vector<long>(solutions[i].routes.size(), 0));
+		tourTime.push_back(vector<double>(solutions[i].routes.size(), 0));
+	}
+
+	vector<thread> workers;
+	for(int i = 0; i < threads; i++)
+		workers.push_back(thread(&ScenarioEval::work, this));
+
+	// read batches while at most two per worker are waiting
+	bool ok = true;
+	long first = 0;
+	while( true )
+	{
+		Batch* batch = new Batch();
+		batch->first = first;
+		ok = readBatch( *is, *batch );
+		if( batch->size == 0 )
+		{
+			delete batch;
+			break;
+		}
+		first += batch->size;
+
+		unique_lock<mutex> guard(queueLock);
+		queueChanged.wait(guard, [this]() { return (int)queue.size() < 2 * threads; });
+		queue.push_back(batch);
+		queueChanged.notify_all();
+		if( !ok || batch->size < BATCH_SIZE )
+			break;
+	}
+	{
+		lock_guard<mutex> guard(queueLock);
+		readerDone = true;
+		queueChanged.notify_all();
+	}
+	for(unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	scenarios = first;
+	if( !ok )
+		cerr << "Cannot read " << scenarioFile << ", " << readError << endl;
+	return ok;
+}
+
+void ScenarioEval::print( ostream& os )
+{
+	os << "Scenarios: " << scenarios << "\n";
+	if( scenarios == 0 )
+		return;
+
+	for(unsigned int i = 0; i < solutions.size(); i++)
+	{
+		const CostStats& stats = costs[i];
+		double mean = stats.sum / scenarios;
+		double deviation = sqrt(max(0.0, stats.squares / scenarios - mean * mean));
+		os << "Solution " << i << ": cost " << solutions[i].cost << "\n";
+		os << "\tscenario cost: mean " << mean << ", deviation " << deviation
+			<< ", min " << stats.min << ", p50 " << stats.percentile(50) << ", p90 " << stats.percentile(90)
+			<< ", p95 " << stats.percentile(95) << ", p99 " << stats.percentile(99) << ", max " << stats.max << "\n";
+		os << "\tP(any tour over T): " << (double)anyLate[i] / scenarios << "\n";
+		for(unsigned int r = 0; r < solutions[i].routes.size(); r++)
+		{
+			os << "\ttour " << r << ": time " << Solution::routeTime(instance, solutions[i].routes[r])
+				<< ", mean " << tourTime[i][r] / scenarios
+				<< ", P(over T) " << (double)late[i][r] / scenarios << "\n";
+		}
+	}
+}
+
+// ----- private methods -----
+
+void ScenarioEval::CostStats::add( double cost )
+{
+	count++;
+	sum += cost;
+	squares += cost * cost;
+	min = std::min(min, cost);
+	max = std::max(max, cost);
+	if( cost <= 0 )
+		zeros++;
+	else
+		buckets[(int)ceil(log(cost) / log(GAMMA))]++;
+}
+
+void ScenarioEval::CostStats::merge( const CostStats& other )
+{
+	count += other.count;
+	sum += other.sum;
+	squares += other.squares;
+	min = std::min(min, other.min);
+	max = std::max(max, other.max);
+	zeros += other.zeros;
+	for(map<int, long>::const_iterator it = other.buckets.begin(); it != other.buckets.end(); ++it)
+		buckets[it->first] += it->second;
+}
+
+double ScenarioEval::CostStats::percentile( double p ) const
+{
+	// nearest rank, the bucket is represented by the value of least relative error
+	long rank = std::max((long)ceil(p / 100.0 * count), 1L);
+	long seen = zeros;
+	if( rank <= seen )
+		return 0;
+	for(map<int, long>::const_iterator it = buckets.begin(); it != buckets.end(); ++it)
+	{
+		seen += it->second;
+		if( rank <= seen )
+			return std::min(std::max(2 * pow(GAMMA, it->first) / (GAMMA + 1), min), max);
+	}
+	return max;
+}
+
+void ScenarioEval::indexArcs()
+{
+	int n = instance.n;
+	arcIndex.assign(n * n, -1);
+	numArcs = 0;
+	tourArcs.clear();
+	for(unsigned int i = 0; i < solutions.size(); i++)
+	{
+		tourArcs.push_back(vector<vector<int> >());
+		for(unsigned int r = 0; r < solutions[i].routes.size(); r++)
+		{
+			const vector<int>& route = solutions[i].routes[r];
+			vector<int> arcs;
+			for(unsigned int k = 0; k <= route.size() && !route.empty(); k++)
+			{
+				int from = k == 0 ? 0 : route[k-1];
+				int to = k == route.size() ? 0 : route[k];
+				if( arcIndex[from * n + to] < 0 )
+					arcIndex[from * n + to] = numArcs++;
+				arcs.push_back(arcIndex[from * n + to]);
+			}
+			tourArcs.back().push_back(arcs);
+		}
+	}
+}
+
+bool ScenarioEval::readBatch( istream& is, Batch& batch )
+{
+	int n = instance.n;
+	batch.size = 0;
+	batch.times.assign(numArcs * BATCH_SIZE, 0);
+	while( batch.size < BATCH_SIZE )
+	{
+		// only the end of the input before a matrix ends the scenarios
+		double d;
+		if( !(is >> d) && is.eof() )
+			return true;
+		for(int k = 0; k < n * n; k++)
+		{
+			if( (k > 0 && !(is >> d)) || is.fail() )
+			{
+				stringstream error;
+				error << "scenario " << batch.first + batch.size << ": "
+					<< (is.eof() ? "missing" : "invalid") << " time " << k / n << " " << k % n;
+				readError = error.str();
+				return false;
+			}
+			if( arcIndex[k] >= 0 )
+				batch.times[arcIndex[k] * BATCH_SIZE + batch.size] = d;
+		}
+		batch.size++;
+	}
+	return true;
+}
+
+void ScenarioEval::work()
+{
+	while( true )
+	{
+		Batch* batch;
+		{
+			unique_lock<mutex> guard(queueLock);
+			queueChanged.wait(guard, [this]() { return !queue.empty() || readerDone; });
+			if( queue.empty() )
+				return;
+			batch = queue.front();
+			queue.pop_front();
+			queueChanged.notify_all();
+		}
+		evaluate( *batch );
+		delete batch;
+	}
+}
+
+void ScenarioEval::evaluate( const Batch& batch )
+{
+	double T = instance.T;
+	vector<CostStats> batchCosts(solutions.size());
+	vector<long> batchAnyLate(solutions.size(), 0);
+	vector<vector<long> > batchLate(solutions.size());
+	vector<vector<double> > batchTourTime(solutions.size());
+
+	double time[BATCH_SIZE];
+	double total[BATCH_SIZE];
+	unsigned char anyOver[BATCH_SIZE];
+	for(unsigned int i = 0; i < solutions.size(); i++)
+	{
+		fill(total, total + BATCH_SIZE, 0.0);
+		fill(anyOver, anyOver + BATCH_SIZE, 0);
+		for(unsigned int r = 0; r < tourArcs[i].size(); r++)
+		{
+			// the tour time in all scenarios of the batch, arc by arc
+			const vector<int>& arcs = tourArcs[i][r];
+			fill(time, time + BATCH_SIZE, 0.0);
+			for(unsigned int a = 0; a < arcs.size(); a++)
+			{
+				const double* t = &batch.times[arcs[a] * BATCH_SIZE];
+				for(int s = 0; s < BATCH_SIZE; s++)
+					time[s] += t[s];
+			}
+
+			long over = 0;
+			double sum = 0;
+			for(int s = 0; s < batch.size; s++)
+			{
+				total[s] += time[s];
+				sum += time[s];
+				over += time[s] > T;
+				anyOver[s] |= time[s] > T;
+			}
+			batchLate[i].push_back(over);
+			batchTourTime[i].push_back(sum);
+		}
+		for(int s = 0; s < batch.size; s++)
+		{
+			batchCosts[i].add(total[s]);
+			batchAnyLate[i] += anyOver[s];
+		}
+	}
+
+	lock_guard<mutex> guard(resultLock);
+	for(unsigned int i = 0; i < solutions.size(); i++)
+	{
+		costs[i].merge(batchCosts[i]);
+		anyLate[i] += batchAnyLate[i];
+		for(unsigned int r = 0; r < late[i].size(); r++)
+		{
+			late[i][r] += batchLate[i][r];
+			tourTime[i][r] += batchTourTime[i][r];
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef __SCENARIO_EVAL__H__
+#define __SCENARIO_EVAL__H__
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include "Tools.h"
+#include "Instance.h"
+#include "Solution.h"
+
+using namespace std;
+
+/**
+ * Scores a set of solutions of one instance under many travel time
+ * scenarios. A scenario file holds full distance matrices of the instance
+ * one after the other in the format of the .prob files; it is streamed in
+ * batches of scenarios, only the arcs used by the solutions are kept. Worker
+ * threads evaluate the batches, the arc times of a batch are stored scenario
+ * by scenario so that summing up a tour runs over all scenarios at once.
+ * Only running aggregates are kept per solution, the cost percentiles come
+ * from a histogram with logarithmic buckets and are exact up to 0.1%.
+ */
+class ScenarioEval
+{
+public:
+
+	// scenarios per batch, a multiple of the vector width
+	static const int BATCH_SIZE = 64;
+
+private:
+
+	Instance& instance;
+	int threads;
+	vector<Solution> solutions;
+
+	// arcs used by any solution, arcIndex[i*n+j] is -1 for the others
+	vector<int> arcIndex;
+	int numArcs;
+	// arcs of every tour of every solution, including the depot arcs
+	vector<vector<vector<int> > > tourArcs;
+
+	struct Batch
+	{
+		long first;				// index of its first scenario
+		int size;				// number of scenarios, at most BATCH_SIZE
+		vector<double> times;	// times[a*BATCH_SIZE + s]: arc a in scenario s
+	};
+
+	// bounded queue between the reader and the workers
+	deque<Batch*> queue;
+	mutex queueLock;
+	condition_variable queueChanged;
+	bool readerDone;
+
+	// distribution of the costs of one solution over the scenarios
+	struct CostStats
+	{
+		long count;
+		double sum, squares, min, max;
+		long zeros;					// costs of 0, outside of the buckets
+		map<int, long> buckets;		// bucket i holds costs in (gamma^(i-1), gamma^i]
+
+		CostStats() : count( 0 ), sum( 0 ), squares( 0 ), min( 1e30 ), max( -1e30 ), zeros( 0 ) {};
+		void add( double cost );
+		void merge( const CostStats& other );
+		// nearest rank, relative error at most the bucket accuracy
+		double percentile( double p ) const;
+	};
+
+	// results, per solution
+	mutex resultLock;
+	long scenarios;
+	vector<CostStats> costs;
+	vector<long> anyLate;				// scenarios with at least one tour over T
+	vector<vector<long> > late;			// by tour
+	vector<vector<double> > tourTime;	// sum over all scenarios, by tour
+
+	string readError;	// scenario and entry where reading failed
+
+	void indexArcs();
+	bool readBatch( istream& is, Batch& batch );
+	void work();
+	void evaluate( const Batch& batch );
+
+public:
+
+	ScenarioEval( Instance& _instance, int _threads = 1 );
+
+	void addSolution( const Solution& sol ) { solutions.push_back( sol ); };
+
+	// evaluates all solutions under every scenario of the file ("-" reads
+	// stdin), returns false if the file cannot be read, ends within a matrix
+	// or holds a value that is not a number
+	bool run( const string& scenarioFile );
+
+	// cost distribution and late tour probabilities of every solution
+	void print( ostream& os );
+};
+
+#endif //__SCENARIO_EVAL__H__
@@ -0,0 +1,439 @@
+#include "Server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+// seconds a client has to send its whole request
+static const double REQUEST_TIMEOUT = 30;
+// connections read at the same time, more are turned away
+static const int MAX_CONNECTIONS = 32;
+// bytes of inline instance data accepted per request
+static const size_t MAX_INLINE_BYTES = 64 << 20;
+// milliseconds between two checks for a shutdown while waiting for connections
+static const int ACCEPT_POLL_INTERVAL = 200;
+
+// engines a job may ask for
+static const char* MODELS[] = { "scf", "mcf", "mtz", "mcf-benders", "tflow", "heuristic" };
+
+Server::Server( const string& _socketPath, int _numWorkers, unsigned int _cacheCapacity ) :
+socketPath( _socketPath ), numWorkers( _numWorkers ), maxQueued( 64 ),
+cacheCapacity( _cacheCapacity ), stopping( false ), connections( 0 ), cacheHits( 0 ), cacheMisses( 0 )
+{
+}
+
+bool Server::run()
+{
+	// clients closing their connection early must not kill the server
+	signal( SIGPIPE, SIG_IGN );
+
+	int listenFd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( listenFd < 0 )
+	{
+		cerr << "Server: cannot create socket\n";
+		return false;
+	}
+
+	sockaddr_un addr;
+	memset( &addr, 0, sizeof(addr) );
+	addr.sun_family = AF_UNIX;
+	strncpy( addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1 );
+	unlink( socketPath.c_str() );
+	if( bind( listenFd, (sockaddr*) &addr, sizeof(addr) ) < 0 || listen( listenFd, 16 ) < 0 )
+	{
+		cerr << "Server: cannot listen on " << socketPath << "\n";
+		close( listenFd );
+		return false;
+	}
+
+	for(int i = 0; i < numWorkers; i++)
+		workers.push_back(thread(&Server::work, this));
+	cout << "Listening on " << socketPath << " with " << numWorkers << " workers\n";
+
+	// every connection is read on a thread of its own, a slow client can
+	// neither block the others nor a shutdown
+	while( true )
+	{
+		{
+			lock_guard<mutex> guard(lock);
+			if( stopping )
+				break;
+		}
+		pollfd listening = { listenFd, POLLIN, 0 };
+		if( poll( &listening, 1, ACCEPT_POLL_INTERVAL ) <= 0 )
+			continue;
+		int fd = accept( listenFd, 0, 0 );
+		if( fd < 0 )
+			continue;
+
+		timeval timeout = { 1, 0 };
+		setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout) );
+		{
+			lock_guard<mutex> guard(lock);
+			if( connections >= MAX_CONNECTIONS )
+			{
+				reply( fd, "{\"error\":\"too many connections\"}" );
+				close( fd );
+				continue;
+			}
+			connections++;
+		}
+		thread(&Server::serveConnection, this, fd).detach();
+	}
+
+	close( listenFd );
+	unlink( socketPath.c_str() );
+	{
+		// the connection threads end by the request timeout at the latest
+		unique_lock<mutex> guard(lock);
+		connectionDone.wait(guard, [this]() { return connections == 0; });
+	}
+	jobAvailable.notify_all();
+	for(unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+	return true;
+}
+
+// ----- private methods -----------------------------------------------
+
+shared_ptr<Instance> Server::loadInstance( const string& path )
+{
+	{
+		lock_guard<mutex> guard(lock);
+		unordered_map<string, list<pair<string, shared_ptr<Instance> > >::iterator>::iterator it = cacheIndex.find(path);
+		if( it != cacheIndex.end() )
+		{
+			cache.splice(cache.begin(), cache, it->second);
+			cacheHits++;
+			return it->second->second;
+		}
+		cacheMisses++;
+	}
+
+	// parse outside of the lock, concurrent misses on the same file are harmless
+	ifstream is( path.c_str(), ios::in );
+	shared_ptr<Instance> instance( new Instance() );
+	if( !is.is_open() || !instance->read(is) )
+		return shared_ptr<Instance>();
+
+	lock_guard<mutex> guard(lock);
+	if( cacheIndex.find(path) == cacheIndex.end() )
+	{
+		cache.push_front(make_pair(path, instance));
+		cacheIndex[path] = cache.begin();
+		if( cache.size() > cacheCapacity )
+		{
+			cacheIndex.erase(cache.back().first);
+			cache.pop_back();
+		}
+	}
+	return instance;
+}
+
+void Server::serveConnection( int fd )
+{
+	handleConnection( fd );
+	lock_guard<mutex> guard(lock);
+	connections--;
+	connectionDone.notify_all();
+}
+
+void Server::handleConnection( int fd )
+{
+	double deadline = Tools::wallTime() + REQUEST_TIMEOUT;
+	string line;
+	if( !readLine(fd, line, deadline) )
+	{
+		close( fd );
+		return;
+	}
+
+	// command followed by key=value arguments
+	stringstream ss( line );
+	string cmd, token;
+	ss >> cmd;
+	map<string, string> args;
+	while( ss >> token )
+	{
+		size_t eq = token.find('=');
+		if( eq == string::npos )
+			args[token] = "";
+		else
+			args[token.substr(0, eq)] = token.substr(eq + 1);
+	}
+
+	if( cmd == "stats" )
+	{
+		lock_guard<mutex> guard(lock);
+		stringstream json;
+		json << "{\"jobs\":" << jobs.size() << ",\"queued\":" << queue.size()
+			<< ",\"cached\":" << cache.size() << ",\"hits\":" << cacheHits
+			<< ",\"misses\":" << cacheMisses << "}";
+		reply( fd, json.str() );
+	}
+	else if( cmd == "shutdown" )
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+		for(map<string, shared_ptr<Job> >::iterator it = jobs.begin(); it != jobs.end(); ++it)
+			cancelJob( *it->second );
+		reply( fd, "{\"status\":\"stopping\"}" );
+	}
+	else if( cmd == "cancel" )
+	{
+		lock_guard<mutex> guard(lock);
+		map<string, shared_ptr<Job> >::iterator it = jobs.find(args["id"]);
+		if( it == jobs.end() )
+			reply( fd, "{\"error\":\"unknown job\"}" );
+		else
+		{
+			cancelJob( *it->second );
+			reply( fd, "{\"id\":" + quote( it->second->id ) + ",\"status\":\"cancelling\"}" );
+		}
+	}
+	else if( cmd == "solve" )
+	{
+		shared_ptr<Job> job( new Job() );
+		job->id = args["id"];
+		job->model = args.count("model") ? args["model"] : "scf";
+		if( find(MODELS, MODELS + sizeof(MODELS) / sizeof(MODELS[0]), job->model) == MODELS + sizeof(MODELS) / sizeof(MODELS[0]) )
+		{
+			reply( fd, "{\"id\":" + quote( job->id ) + ",\"error\":\"unknown model\"}" );
+			close( fd );
+			return;
+		}
+		job->timeLimit = args.count("time") ? atof(args["time"].c_str()) : 60;
+		job->fd = fd;
+		job->cancelled = false;
+		job->ilp = 0;
+		job->heuristic = 0;
+
+		if( args.count("inline") )
+		{
+			// instance data follows until a line "end"
+			string data;
+			bool complete = false;
+			while( !complete && data.size() < MAX_INLINE_BYTES && readLine(fd, line, deadline) )
+			{
+				complete = line == "end";
+				if( !complete )
+					data += line + "\n";
+			}
+			string error = "incomplete instance data";
+			if( complete )
+			{
+				stringstream is( data );
+				job->instance.reset( new Instance() );
+				if( !job->instance->read(is) )
+				{
+					error = "cannot parse instance: " + job->instance->getParseError();
+					job->instance.reset();
+				}
+			}
+			if( !job->instance )
+			{
+				reply( fd, "{\"id\":" + quote( job->id ) + ",\"error\":" + quote( error ) + "}" );
+				close( fd );
+				return;
+			}
+		}
+		else
+			job->instance = loadInstance( args["file"] );
+
+		if( !job->instance )
+		{
+			reply( fd, "{\"id\":" + quote( job->id ) + ",\"error\":\"cannot load instance\"}" );
+			close( fd );
+			return;
+		}
+
+		lock_guard<mutex> guard(lock);
+		if( job->id.empty() || jobs.count(job->id) || queue.size() >= maxQueued )
+		{
+			reply( fd, "{\"id\":" + quote( job->id ) + ",\"error\":\"job id missing or in use, or queue full\"}" );
+			close( fd );
+			return;
+		}
+		jobs[job->id] = job;
+		queue.push_back(job);
+		jobAvailable.notify_one();
+		// the connection stays open until the worker has replied
+		return;
+	}
+	else
+		reply( fd, "{\"error\":\"unknown command\"}" );
+
+	close( fd );
+}
+
+void Server::work()
+{
+	while( true )
+	{
+		shared_ptr<Job> job;
+		{
+			unique_lock<mutex> guard(lock);
+			while( queue.empty() && !stopping )
+				jobAvailable.wait(guard);
+			if( queue.empty() )
+				return;
+			job = queue.front();
+			queue.pop_front();
+		}
+
+		runJob( *job );
+
+		lock_guard<mutex> guard(lock);
+		jobs.erase(job->id);
+	}
+}
+
+void Server::runJob( Job& job )
+{
+	double startTime = Tools::wallTime();
+	stringstream json;
+	json << "{\"id\":" << quote( job.id ) << ",\"model\":" << quote( job.model );
+
+	Instance& instance = *job.instance;
+	Solution sol;
+	bool hasSolution = false;
+
+	if( job.model == "heuristic" )
+	{
+		HeuristicSolver heuristic( instance );
+		heuristic.setTimeLimit( job.timeLimit );
+		{
+			lock_guard<mutex> guard(lock);
+			job.heuristic = &heuristic;
+			if( job.cancelled )
+				heuristic.abort();
+		}
+		hasSolution = heuristic.solve( true );
+		{
+			lock_guard<mutex> guard(lock);
+			job.heuristic = 0;
+		}
+		sol = heuristic.getSolution();
+		json << ",\"status\":\"" << (hasSolution ? "Feasible" : "Unknown") << "\"";
+	}
+	else
+	{
+		tcbvrp_ILP ilp( instance, job.model, false );
+		ilp.setQuiet( true );
+		ilp.setTimeLimit( job.timeLimit );
+		{
+			lock_guard<mutex> guard(lock);
+			job.ilp = &ilp;
+			if( job.cancelled )
+				ilp.abort();
+		}
+		bool ok = ilp.solve();
+		{
+			lock_guard<mutex> guard(lock);
+			job.ilp = 0;
+		}
+		const tcbvrp_ILP::Result& result = ilp.getResult();
+		hasSolution = ok && result.hasSolution;
+		sol = result.solution;
+		json << ",\"status\":\"" << result.status << "\",\"nodes\":" << result.nodes;
+		if( ok && result.bound > -IloInfinity )
+			json << ",\"bound\":" << result.bound;
+	}
+
+	if( job.cancelled )
+		json << ",\"cancelled\":true";
+	if( hasSolution )
+	{
+		json << ",\"objective\":" << sol.cost << ",\"routes\":[";
+		bool first = true;
+		for(unsigned int r = 0; r < sol.routes.size(); r++)
+		{
+			if( sol.routes[r].empty() )
+				continue;
+			json << (first ? "[" : ",[");
+			first = false;
+			for(unsigned int i = 0; i < sol.routes[r].size(); i++)
+				json << (i ? "," : "") << sol.routes[r][i];
+			json << "]";
+		}
+		json << "]";
+	}
+	json << ",\"time\":" << Tools::wallTime() - startTime << "}";
+
+	reply( job.fd, json.str() );
+	close( job.fd );
+}
+
+void Server::cancelJob( Job& job )
+{
+	job.cancelled = true;
+	if( job.ilp )
+		job.ilp->abort();
+	if( job.heuristic )
+		job.heuristic->abort();
+}
+
+bool Server::readLine( int fd, string& line, double deadline )
+{
+	line.clear();
+	char c;
+	while( true )
+	{
+		// the socket has a receive timeout, so the deadline and a shutdown are
+		// noticed within a second
+		if( Tools::wallTime() > deadline )
+			return false;
+		ssize_t r = recv( fd, &c, 1, 0 );
+		if( r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) )
+		{
+			lock_guard<mutex> guard(lock);
+			if( stopping )
+				return false;
+			continue;
+		}
+		if( r < 0 )
+			return false;
+		if( r == 0 )
+			return !line.empty();
+		if( c == '\n' )
+			return true;
+		line += c;
+	}
+}
+
+void Server::reply( int fd, const string& json )
+{
+	string msg = json + "\n";
+	size_t sent = 0;
+	while( sent < msg.size() )
+	{
+		ssize_t r = send( fd, msg.data() + sent, msg.size() - sent, 0 );
+		if( r <= 0 )
+			return;
+		sent += r;
+	}
+}
+
+string Server::quote( const string& value )
+{
+	string json = "\"";
+	for(unsigned int i = 0; i < value.size(); i++)
+	{
+		unsigned char c = value[i];
+		if( c == '"' || c == '\\' )
+			json += string( "\\" ) + (char) c;
+		else if( c < 0x20 )
+		{
+			char escaped[8];
+			snprintf( escaped, sizeof(escaped), "\\u%04x", c );
+			json += escaped;
+		}
+		else
+			json += c;
+	}
+	return json + "\"";
+}
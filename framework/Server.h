@@ -0,0 +1,93 @@
+#ifndef __SERVER__H__
+#define __SERVER__H__
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "Tools.h"
+#include "Instance.h"
+#include "tcbvrp_ILP.h"
+#include "HeuristicSolver.h"
+
+using namespace std;
+
+/**
+ * Long-lived solver service on a Unix domain socket. Every connection sends
+ * one request line and receives one JSON line:
+ *
+ *   solve id=<job> file=<path> [model=scf|mcf|mtz|mcf-benders|tflow|heuristic] [time=<seconds>]
+ *   solve id=<job> inline [model=...] [time=...]   followed by the instance and a line "end"
+ *   cancel id=<job>
+ *   stats
+ *   shutdown
+ *
+ * Parsed instances are kept in an LRU cache, jobs run on a bounded pool of
+ * worker threads and can be cancelled while queued or running. Every
+ * connection is read on a thread of its own with a deadline for the request.
+ */
+class Server
+{
+private:
+
+	struct Job
+	{
+		string id;
+		string model;
+		double timeLimit;
+		shared_ptr<Instance> instance;
+		int fd;				// connection the result is written to
+
+		// solver of the running job, guarded by Server::lock
+		bool cancelled;
+		tcbvrp_ILP* ilp;
+		HeuristicSolver* heuristic;
+	};
+
+	string socketPath;
+	int numWorkers;
+	unsigned int maxQueued;
+	unsigned int cacheCapacity;
+
+	mutex lock;
+	condition_variable jobAvailable;
+	deque<shared_ptr<Job> > queue;
+	map<string, shared_ptr<Job> > jobs;	// queued and running jobs by id
+	bool stopping;
+	int connections;					// connections being read
+	condition_variable connectionDone;
+
+	// LRU cache of parsed instances, most recently used first
+	list<pair<string, shared_ptr<Instance> > > cache;
+	unordered_map<string, list<pair<string, shared_ptr<Instance> > >::iterator> cacheIndex;
+	unsigned int cacheHits, cacheMisses;
+
+	vector<thread> workers;
+
+	shared_ptr<Instance> loadInstance( const string& path );
+	void serveConnection( int fd );
+	void handleConnection( int fd );
+	void work();
+	void runJob( Job& job );
+	// stops a queued or running job, the caller holds the lock
+	void cancelJob( Job& job );
+
+	// false on errors, once the deadline (wall time) has passed and on shutdown
+	bool readLine( int fd, string& line, double deadline );
+	static void reply( int fd, const string& json );
+	// JSON string literal of a client supplied value
+	static string quote( const string& value );
+
+public:
+
+	Server( const string& _socketPath, int _numWorkers = 2, unsigned int _cacheCapacity = 32 );
+
+	// accepts connections until a shutdown request arrives
+	bool run();
+};
+
+#endif //__SERVER__H__
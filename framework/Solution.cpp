@@ -0,0 +1,73 @@
+#include "Solution.h"
+
+double Solution::routeTime( Instance& instance, const vector<int>& route )
+{
+	if( route.empty() )
+		return 0;
+
+	double time = instance.getDistance(0, route[0]);
+	for(unsigned int i = 1; i < route.size(); i++)
+		time += instance.getDistance(route[i-1], route[i]);
+	return time + instance.getDistance(route.back(), 0);
+}
+
+double Solution::evaluate( Instance& instance )
+{
+	cost = 0;
+	for(unsigned int r = 0; r < routes.size(); r++)
+		cost += routeTime(instance, routes[r]);
+	return cost;
+}
+
+bool Solution::isFeasible( Instance& instance ) const
+{
+	vector<bool> visited(instance.n, false);
+	int numTours = 0;
+
+	for(unsigned int r = 0; r < routes.size(); r++)
+	{
+		const vector<int>& route = routes[r];
+		if( route.empty() )
+			continue;
+		numTours++;
+
+		// a tour alternates supply and demand nodes: S D S D ... S D
+		if( route.size() % 2 != 0 )
+			return false;
+		for(unsigned int i = 0; i < route.size(); i++)
+		{
+			int v = route[i];
+			if( v <= 0 || v >= instance.n || visited[v] )
+				return false;
+			if( i % 2 == 0 ? !instance.isSupplyNode(v) : !instance.isDemandNode(v) || !instance.isRequired(v) )
+				return false;
+			visited[v] = true;
+		}
+
+		if( routeTime(instance, route) > instance.T )
+			return false;
+	}
+
+	if( numTours > instance.m )
+		return false;
+
+	const vector<int>& demandNodes = instance.getDemandNodes();
+	for(unsigned int i = 0; i < demandNodes.size(); i++)
+	{
+		if( instance.isRequired(demandNodes[i]) && !visited[demandNodes[i]] )
+			return false;
+	}
+	return true;
+}
+
+void Solution::print( ostream& os ) const
+{
+	for(unsigned int r = 0; r < routes.size(); r++)
+	{
+		os << "Tour " << r << ": 0";
+		for(unsigned int i = 0; i < routes[r].size(); i++)
+			os << " " << routes[r][i];
+		os << " 0\n";
+	}
+	os << "Total travel time: " << cost << "\n";
+}
@@ -0,0 +1,34 @@
+#ifndef __SOLUTION__H__
+#define __SOLUTION__H__
+
+#include "Instance.h"
+
+using namespace std;
+
+/** A TCBVRP solution given as the sequence of stations visited by each tour. */
+class Solution
+{
+public:
+
+	// stations of each tour in visiting order, the depot (node 0) is implicit at both ends
+	vector<vector<int> > routes;
+
+	// total travel time, set by evaluate()
+	double cost;
+
+	Solution() : cost( 0 ) {};
+
+	// travel time of a single tour including the way from and to the depot
+	static double routeTime( Instance& instance, const vector<int>& route );
+
+	// recomputes and returns the total travel time
+	double evaluate( Instance& instance );
+
+	// checks alternation of supply and demand nodes, coverage of every
+	// required demand node, the number of tours and the time limit of each tour
+	bool isFeasible( Instance& instance ) const;
+
+	void print( ostream& os ) const;
+};
+
+#endif //__SOLUTION__H__
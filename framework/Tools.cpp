@@ -1,11 +1,12 @@
 #include "Tools.h"
 
-string Tools::indicesToString( string prefix, int i, int j, int v )
+string Tools::indicesToString( string prefix, int i, int j, int v, int w )
 {
 	stringstream ss;
 	ss << prefix << "(" << i;
 	if( j >= 0 ) ss << ',' << j;
 	if( v >= 0 ) ss << ',' << v;
+	if( w >= 0 ) ss << ',' << w;
 	ss << ')';
 	return ss.str();
 }
@@ -17,3 +18,17 @@ double Tools::CPUtime()
 	double ct = sysconf( _SC_CLK_TCK );
 	return t.tms_utime / ct;
 }
+
+double Tools::wallTime()
+{
+	timeval tv;
+	gettimeofday( &tv, 0 );
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+long Tools::peakRSS()
+{
+	rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+	return usage.ru_maxrss;
+}
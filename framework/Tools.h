@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <iomanip>
 #include <sys/times.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 using namespace std;
@@ -20,9 +22,13 @@ using namespace std;
 namespace Tools
 {
 	// generate string from edge indices
-	string indicesToString( string prefix, int i, int j = -1, int v = -1 );
+	string indicesToString( string prefix, int i, int j = -1, int v = -1, int w = -1 );
 	// measure running time
 	double CPUtime();
+	// wall clock time in seconds, independent of the number of threads
+	double wallTime();
+	// peak resident set size of the process (in kB)
+	long peakRSS();
 }
 ;
 // Tools
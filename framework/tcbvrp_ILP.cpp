@@ -1,7 +1,22 @@
 #include "tcbvrp_ILP.h"
+#include <cassert>
 
-tcbvrp_ILP::tcbvrp_ILP( Instance& _instance, string _model_type) :
-instance( _instance ), model_type( _model_type )
+// every ROUNDING_FREQ-th call of the heuristic callback hands the LP solution to the workers
+static const IloInt ROUNDING_FREQ = 10;
+
+// seconds of native search for the upper bound used in reduced cost fixing
+static const double FIXING_HEURISTIC_TIME = 5;
+
+// minimum violation of a separated Benders cut at fractional points
+static const IloNum FLOW_CUT_VIOLATION = 0.1;
+
+// a constraint family is assembled and loaded in this many parts
+static const long ASSEMBLY_SLICES = 16;
+
+tcbvrp_ILP::tcbvrp_ILP( Instance& _instance, string _model_type, bool _namedVars) :
+instance( _instance ), model_type( _model_type ), namedVars( _namedVars ),
+heuristicThreads( 0 ), quiet( false ), timeLimit( 3600 ), reducedCostFixing( false ), pairGraphReduction( false ), buildThreads( 1 ), pairGraph( 0 ), tBlock( -1 ), checkpoint( 0 ), resumeSettings( false ), hasStartSolution( false ), pool( &ownPool ), heuristic( 0 ),
+ownsHeuristic( false ), abortRequested( false ), hasAborter( false )
 {
 	//Number of stations + depot
 	n = instance.n;
@@ -15,82 +30,908 @@ instance( _instance ), model_type( _model_type )
 
 tcbvrp_ILP::~tcbvrp_ILP()
 {
+	if( ownsHeuristic )
+		delete heuristic;
+	delete pairGraph;
+
 	// free CPLEX resources
 	cplex.end();
 	model.end();
 	env.end();
 }
 
-void tcbvrp_ILP::solve()
+void tcbvrp_ILP::shareSolutions(SolutionPool* _pool, ConcurrentHeuristic* _heuristic)
 {
-	try {
-		// initialize CPLEX solver
-		env = IloEnv();
-		model = IloModel( env );
-
-		// add model-specific constraints
-		if( model_type == "scf" )
-			modelSCF();
-		else if( model_type == "mcf" )
-			modelMCF();
-		else if( model_type == "mtz" )
-			modelMTZ();
+	pool = _pool;
+	heuristic = _heuristic;
+}
 
-		// build model
-		cplex = IloCplex( model );
+bool tcbvrp_ILP::solve()
+{
+	double startTime = Tools::wallTime();
+	try {
+		buildModel();
 
-		// export model to a text file
-		//cplex.exportModel( "model.lp" );
+		// eliminate arcs which cannot be part of an improving solution
+		if( reducedCostFixing )
+			fixByReducedCosts();
 
-		// set parameters
-		setCPLEXParameters();
+		optimize( startTime );
+	}
+	catch( IloException& e ) {
+		cerr << "tcbvrp_ILP: exception " << e << "\n";
+		result.status = IloAlgorithm::Error;
+		return false;
+	}
+	catch( invalid_argument& e ) {
+		cerr << "tcbvrp_ILP: " << e.what() << "\n";
+		result.status = IloAlgorithm::Error;
+		return false;
+	}
+	catch( ... ) {
+		cerr << "tcbvrp_ILP: unknown exception.\n";
+		result.status = IloAlgorithm::Error;
+		return false;
+	}
+	return true;
+}
 
-		// solve model
-		cout << "Calling CPLEX solve ...\n";
+bool tcbvrp_ILP::solveRoot(bool withCuts)
+{
+	rootResult = RootResult();
+	try {
+		double startTime = Tools::wallTime();
+		buildModel();
+		rootResult.buildTime = Tools::wallTime() - startTime;
+		rootResult.rows = cplex.getNrows();
+		rootResult.cols = cplex.getNcols();
+		rootResult.nonzeros = cplex.getNNZs();
+
+		// LP relaxation, the Benders model without any of its flow cuts
+		IloConversion relaxation = addRelaxation();
+		startTime = Tools::wallTime();
 		cplex.solve();
-		cout << "CPLEX finished." << "\n\n";
-		cout << "CPLEX status: " << cplex.getStatus() << "\n";
-		cout << "Branch-and-Bound nodes: " << cplex.getNnodes() << "\n";
-		cout << "Objective value: " << cplex.getObjValue() << "\n";
-		cout << "CPU time: " << Tools::CPUtime() << "\n\n";
-
-		//Copied from: http://orinanobworld.blogspot.co.at/2010/08/iterating-over-cplex-model-sequel.html
-		for (IloIterator<IloNumVar>  it(env); it.ok(); ++it) {
-			try {
-			IloNumVar ext = *it;
-			if(cplex.getValue(ext)!=0)
-				cout << ext.getName() << ": " << cplex.getValue(ext) << "\n";
-			} catch (IloException &e){
-				//cerr << "Exception for variable " << e << "\n";
-			}
+		rootResult.lpTime = Tools::wallTime() - startTime;
+		rootResult.lpStatus = cplex.getStatus();
+		if( rootResult.lpStatus == IloAlgorithm::Optimal )
+			rootResult.lpBound = cplex.getObjValue();
+		model.remove(relaxation);
+		relaxation.end();
+
+		if( !withCuts )
+			return true;
+
+		// root node of the MIP with CPLEX cuts (and the flow cuts of the Benders model)
+		if( model_type == "mcf-benders" )
+		{
+			cplex.use( IloCplex::Callback( new (env) FlowCutCallbackI( env, *this ) ) );
+			cplex.use( IloCplex::Callback( new (env) FlowUserCutCallbackI( env, *this ) ) );
 		}
+		cplex.setParam( IloCplex::NodeLim, 0 );
+		startTime = Tools::wallTime();
+		cplex.solve();
+		rootResult.rootTime = Tools::wallTime() - startTime;
+		rootResult.rootBound = cplex.getBestObjValue();
+		rootResult.hasRootBound = true;
 	}
 	catch( IloException& e ) {
 		cerr << "tcbvrp_ILP: exception " << e << "\n";
-		exit( -1 );
+		return false;
+	}
+	catch( invalid_argument& e ) {
+		cerr << "tcbvrp_ILP: " << e.what() << "\n";
+		return false;
 	}
 	catch( ... ) {
 		cerr << "tcbvrp_ILP: unknown exception.\n";
-		exit( -1 );
+		return false;
 	}
+	return true;
+}
+
+bool tcbvrp_ILP::resolve()
+{
+	double startTime = Tools::wallTime();
+	try {
+		warmStart();
+		optimize( startTime );
+	}
+	catch( IloException& e ) {
+		cerr << "tcbvrp_ILP: exception " << e << "\n";
+		result.status = IloAlgorithm::Error;
+		return false;
+	}
+	catch( ... ) {
+		cerr << "tcbvrp_ILP: unknown exception.\n";
+		result.status = IloAlgorithm::Error;
+		return false;
+	}
+	return true;
+}
+
+void tcbvrp_ILP::setNodeCoverage(int node, bool required)
+{
+	if( !instance.isDemandNode(node) )
+		return;
+	instance.setRequired(node, required);
+	if( coverRows.empty() )
+		return;
+
+	// a cancelled demand node must not be left at all
+	IloNum rhs = required ? 1 : 0;
+	coverRows[node].setBounds(rhs, rhs);
+	supplyCountRow.setBounds(instance.numRequiredDemands(), instance.numRequiredDemands());
+}
+
+void tcbvrp_ILP::setArcTime(int i, int j, double time)
+{
+	instance.setDistance(i, j, time);
+	if( tBlock < 0 )
+		return;
+
+	IloNumVarArray tVars = varBlocks[tBlock].vars;
+	for(unsigned int l = 0; l < m; l++)
+	{
+		objective.setLinearCoef(tVars[(l*n + i)*n + j], time);
+		if( !timeRows.empty() )
+			timeRows[l].setLinearCoef(tVars[(l*n + i)*n + j], time);
+		if( !timeFlowRows.empty() )
+			timeFlowRows[l*n + i].setLinearCoef(tVars[(l*n + i)*n + j], -time);
+	}
+	if( !timeFlowArcs.empty() )
+		updateTimeFlowBounds();
+}
+
+void tcbvrp_ILP::setRouteTimeLimit(int limit)
+{
+	instance.T = T = limit;
+	for(unsigned int l = 0; l < timeRows.size(); l++)
+		timeRows[l].setUB(limit);
+	if( !timeFlowArcs.empty() )
+		updateTimeFlowBounds();
+}
+
+void tcbvrp_ILP::abort()
+{
+	lock_guard<mutex> guard(abortLock);
+	abortRequested = true;
+	if( hasAborter )
+		aborter.abort();
 }
 
 // ----- private methods -----------------------------------------------
 
+int tcbvrp_ILP::addVarBlock(string prefix, int d0, int d1, int d2, int d3)
+{
+	VarBlock block;
+	block.prefix = prefix;
+	block.dims.push_back(d0);
+	if( d1 >= 0 ) block.dims.push_back(d1);
+	if( d2 >= 0 ) block.dims.push_back(d2);
+	if( d3 >= 0 ) block.dims.push_back(d3);
+	block.vars = IloNumVarArray(env);
+	varBlocks.push_back(block);
+	return varBlocks.size() - 1;
+}
+
+void tcbvrp_ILP::registerVar(int block, IloNumVar var, int i, int j, int k, int l)
+{
+	// variables have to be registered in row-major order of their indices
+	varBlocks[block].vars.add(var);
+	if( namedVars )
+		var.setName(Tools::indicesToString( varBlocks[block].prefix, i, j, k, l ).c_str());
+}
+
+long tcbvrp_ILP::encodeColumn(int block, int i, int j, int k, int l)
+{
+	int idx[4] = { i, j, k, l };
+	long col = 0;
+	for(unsigned int d = 0; d < varBlocks[block].dims.size(); d++)
+		col = col * varBlocks[block].dims[d] + idx[d];
+	assert( col < ((long)1 << COLUMN_BITS) );
+	return ((long)block << COLUMN_BITS) | col;
+}
+
+IloNumVar tcbvrp_ILP::columnVar(long id)
+{
+	unsigned long block = id >> COLUMN_BITS;
+	long col = id & (((long)1 << COLUMN_BITS) - 1);
+	assert( block < varBlocks.size() );
+	assert( col < varBlocks[block].vars.getSize() );
+	return varBlocks[block].vars[col];
+}
+
+void tcbvrp_ILP::addRows(long count, const RowAssembler::Family& family)
+{
+	// the rows are assembled on buildThreads threads, but Concert objects may only be
+	// created by one thread: every slice is loaded in bulk as one range array built
+	// from the bounds, the terms of a row in one call and one model.add
+	RowAssembler assembler(buildThreads);
+	long slice = max(count / ASSEMBLY_SLICES, 1L);
+	IloNumVarArray vars(env);
+	IloNumArray vals(env);
+	for(long first = 0; first < count; first += slice)
+	{
+		long size = min(slice, count - first);
+		vector<RowAssembler::Rows> chunks = assembler.assemble(size,
+			[first, &family](long outer, RowAssembler::Rows& rows) { family(first + outer, rows); });
+
+		IloNumArray lbs(env);
+		IloNumArray ubs(env);
+		for(unsigned int c = 0; c < chunks.size(); c++)
+		{
+			for(size_t r = 0; r < chunks[c].size(); r++)
+			{
+				lbs.add(chunks[c].lb[r]);
+				ubs.add(chunks[c].ub[r]);
+			}
+		}
+		IloRangeArray ranges(env, lbs, ubs);
+		IloInt row = 0;
+		for(unsigned int c = 0; c < chunks.size(); c++)
+		{
+			const RowAssembler::Rows& rows = chunks[c];
+			for(size_t r = 0; r < rows.size(); r++, row++)
+			{
+				vars.clear();
+				vals.clear();
+				for(long t = rows.beg[r]; t < rows.rowEnd(r); t++)
+				{
+					vars.add(columnVar(rows.ind[t]));
+					vals.add(rows.val[t]);
+				}
+				ranges[row].setLinearCoefs(vars, vals);
+			}
+		}
+		model.add(ranges);
+		ranges.end();
+		lbs.end();
+		ubs.end();
+	}
+	vars.end();
+	vals.end();
+}
+
+void tcbvrp_ILP::decodeIndices(const VarBlock& block, IloInt col, int idx[4])
+{
+	idx[0] = idx[1] = idx[2] = idx[3] = -1;
+	for(int d = block.dims.size() - 1; d >= 0; d--)
+	{
+		idx[d] = col % block.dims[d];
+		col /= block.dims[d];
+	}
+}
+
+string tcbvrp_ILP::decodeColumn(const VarBlock& block, IloInt col)
+{
+	int idx[4];
+	decodeIndices(block, col, idx);
+	return Tools::indicesToString( block.prefix, idx[0], idx[1], idx[2], idx[3] );
+}
+
+void tcbvrp_ILP::printSolution()
+{
+	for(unsigned int b = 0; b < varBlocks.size(); b++)
+	{
+		IloNumVarArray vars = varBlocks[b].vars;
+		for(IloInt col = 0; col < vars.getSize(); col++)
+		{
+			// variables which do not appear in any constraint are not extracted
+			if( !cplex.isExtracted(vars[col]) )
+				continue;
+			try {
+				IloNum value = cplex.getValue(vars[col]);
+				if( value != 0 )
+					cout << decodeColumn(varBlocks[b], col) << ": " << value << "\n";
+			} catch (IloException &e){
+				//cerr << "Exception for variable " << e << "\n";
+			}
+		}
+	}
+}
+
+void tcbvrp_ILP::initStartVars()
+{
+	startVars = IloNumVarArray(env);
+	startCols.clear();
+	for(unsigned int b = 0; b < varBlocks.size(); b++)
+	{
+		IloNumVarArray vars = varBlocks[b].vars;
+		for(IloInt col = 0; col < vars.getSize(); col++)
+		{
+			if( cplex.isExtracted(vars[col]) && !isUnusedArc(vars[col]) )
+			{
+				startVars.add(vars[col]);
+				startCols.push_back(make_pair(b, col));
+			}
+		}
+	}
+}
+
+Solution tcbvrp_ILP::valuesToSolution(const IloNumArray& tValues)
+{
+	/*
+	 * follow the arc with the highest value from the depot on each tour,
+	 * the result does not have to be feasible (LocalSearch::repair)
+	 */
+
+	Solution sol;
+	sol.routes.resize(m);
+	vector<bool> visited(n, false);
+	for(unsigned int i = 0; i < m; i++)
+	{
+		unsigned int cur = 0;
+		while( true )
+		{
+			int next = -1;
+			IloNum bestValue = max(tValues[(i*n + cur)*n], 1e-6);
+			for(unsigned int k = 1; k < n; k++)
+			{
+				if( !visited[k] && tValues[(i*n + cur)*n + k] > bestValue )
+				{
+					next = k;
+					bestValue = tValues[(i*n + cur)*n + k];
+				}
+			}
+			if( next < 0 )
+				break;
+			visited[next] = true;
+			sol.routes[i].push_back(next);
+			cur = next;
+		}
+	}
+	return sol;
+}
+
+IloNumArray tcbvrp_ILP::solutionToValues(const Solution& sol)
+{
+	/*
+	 * position (starting at 1), successor and departure time of every node on each tour
+	 */
+
+	vector<vector<int> > pos(m, vector<int>(n, 0));
+	vector<vector<int> > succ(m, vector<int>(n, -1));
+	vector<int> len(m, 0);
+	vector<vector<double> > departure(m, vector<double>(n, 0));
+	vector<bool> visited(n, false);
+	for(unsigned int i = 0; i < m && i < sol.routes.size(); i++)
+	{
+		const vector<int>& route = sol.routes[i];
+		if( route.empty() )
+			continue;
+		len[i] = route.size();
+		int prev = 0;
+		for(unsigned int p = 0; p < route.size(); p++)
+		{
+			pos[i][route[p]] = p + 1;
+			succ[i][prev] = route[p];
+			visited[route[p]] = true;
+			departure[i][route[p]] = departure[i][prev] + instance.getDistance(prev, route[p]);
+			prev = route[p];
+		}
+		succ[i][prev] = 0;
+	}
+
+	/*
+	 * values of the variables of all formulations derived from the tours
+	 */
+
+	IloNumArray values(env, startVars.getSize());
+	for(unsigned int c = 0; c < startCols.size(); c++)
+	{
+		const VarBlock& block = varBlocks[startCols[c].first];
+		int idx[4];
+		decodeIndices(block, startCols[c].second, idx);
+
+		IloNum value = 0;
+		if( block.prefix == "t_" )
+			value = succ[idx[0]][idx[1]] == idx[2];
+		else if( block.prefix == "r_" )
+			value = len[idx[0]] > 0;
+		else if( block.prefix == "s_" )
+			value = visited[idx[0]] && instance.isSupplyNode(idx[0]);
+		else if( block.prefix == "u_" )
+			value = pos[idx[0]][idx[1]];
+		else if( block.prefix == "g_" )
+		{
+			// time flow: arrival time at the head of the arc
+			if( succ[idx[0]][idx[1]] == idx[2] )
+				value = departure[idx[0]][idx[1]] + instance.getDistance(idx[1], idx[2]);
+		}
+		else if( block.prefix == "f_" && block.dims.size() == 3 )
+		{
+			// single commodity: number of nodes still to be served behind the arc
+			if( succ[idx[0]][idx[1]] == idx[2] && idx[2] != 0 )
+				value = len[idx[0]] - pos[idx[0]][idx[2]] + 1;
+		}
+		else if( block.prefix == "f_" )
+		{
+			// multi commodity: commodity k uses all arcs of its tour up to node k
+			int l = idx[0], k = idx[1], from = idx[2], to = idx[3];
+			if( succ[l][from] == to && to != 0 && pos[l][k] > 0 && pos[l][to] <= pos[l][k] )
+				value = 1;
+		}
+		values[c] = value;
+	}
+	return values;
+}
+
+tcbvrp_ILP::InjectionCallbackI::InjectionCallbackI( IloEnv env, tcbvrp_ILP& _ilp ) :
+IloCplex::HeuristicCallbackI( env ), ilp( _ilp ), lastIncumbent( IloInfinity ),
+lastInjected( IloInfinity ), calls( 0 )
+{
+}
+
+IloCplex::CallbackI* tcbvrp_ILP::InjectionCallbackI::duplicateCallback() const
+{
+	return new (getEnv()) InjectionCallbackI( *this );
+}
+
+void tcbvrp_ILP::InjectionCallbackI::main()
+{
+	IloNumVarArray tVars = ilp.varBlocks[ilp.tBlock].vars;
+	IloNumArray values(getEnv());
+
+	// hand new incumbents of CPLEX to the pool and the workers
+	if( hasIncumbent() && getIncumbentObjValue() < lastIncumbent - 1e-6 )
+	{
+		lastIncumbent = getIncumbentObjValue();
+		getIncumbentValues(values, tVars);
+		Solution incumbent = ilp.valuesToSolution(values);
+		incumbent.evaluate(ilp.instance);
+		if( incumbent.isFeasible(ilp.instance) )
+			ilp.pool->offer(incumbent);
+		if( ilp.heuristic )
+			ilp.heuristic->submit(incumbent);
+	}
+
+	// the best known solution and the global bound, written every few minutes
+	if( ilp.checkpoint )
+	{
+		Solution best;
+		if( ilp.pool->getBest(best) )
+			ilp.checkpoint->save(best, getBestObjValue());
+	}
+
+	// the rounded LP solution of the current node is a seed as well
+	if( ilp.heuristic && calls++ % ROUNDING_FREQ == 0 )
+	{
+		getValues(values, tVars);
+		ilp.heuristic->submit(ilp.valuesToSolution(values));
+	}
+	values.end();
+
+	// inject the best solution of the workers if it beats the incumbent
+	Solution best;
+	if( ilp.pool->getBest(best) && best.cost < lastInjected - 1e-6
+		&& (!hasIncumbent() || best.cost < getIncumbentObjValue() - 1e-6) )
+	{
+		lastInjected = best.cost;
+		IloNumArray startValues = ilp.solutionToValues(best);
+		setSolution(ilp.startVars, startValues, best.cost);
+		startValues.end();
+	}
+}
+
+void tcbvrp_ILP::FlowCutCallbackI::main()
+{
+	IloNumArray values(getEnv());
+	getValues(values, ilp.varBlocks[ilp.tBlock].vars);
+	vector<IloRange> cuts;
+	ilp.separateFlowCuts(getEnv(), values, 1e-6, cuts);
+	for(unsigned int c = 0; c < cuts.size(); c++)
+		add(cuts[c]).end();
+	values.end();
+}
+
+void tcbvrp_ILP::FlowUserCutCallbackI::main()
+{
+	// fractional separation only at the root node to keep the node throughput
+	if( getNnodes() > 0 )
+		return;
+	IloNumArray values(getEnv());
+	getValues(values, ilp.varBlocks[ilp.tBlock].vars);
+	vector<IloRange> cuts;
+	ilp.separateFlowCuts(getEnv(), values, FLOW_CUT_VIOLATION, cuts);
+	for(unsigned int c = 0; c < cuts.size(); c++)
+		add(cuts[c]).end();
+	values.end();
+}
+
+void tcbvrp_ILP::printResourceUsage(string phase)
+{
+	IloInt numVars = 0;
+	for(unsigned int b = 0; b < varBlocks.size(); b++)
+		numVars += varBlocks[b].vars.getSize();
+
+	IloInt numObjects = 0;
+	for(IloModel::Iterator it(model); it.ok(); ++it)
+		numObjects++;
+
+	cout << "Resources after " << phase << ": "
+		<< "peak RSS " << Tools::peakRSS() << " kB, "
+		<< "Concert memory " << env.getMemoryUsage() / 1024 << " kB, "
+		<< numVars << " variables, "
+		<< numObjects << " model objects, "
+		<< cplex.getNcols() << " columns, "
+		<< cplex.getNrows() << " rows, "
+		<< cplex.getNNZs() << " non-zeros\n";
+}
+
 void tcbvrp_ILP::setCPLEXParameters()
 {
 	// print every line of node-log and give more details
 	cplex.setParam( IloCplex::MIPInterval, 1 );
 	cplex.setParam( IloCplex::MIPDisplay, 2 );
 
-	// deactivate CPLEX general-purpose cuts
-	//	cplex.setParam( IloCplex::EachCutLim, 0 );
-	//	cplex.setParam( IloCplex::FracCuts, -1 );
+	// deactivate CPLEX general-purpose cuts
+	//	cplex.setParam( IloCplex::EachCutLim, 0 );
+	//	cplex.setParam( IloCplex::FracCuts, -1 );
+
+	// only use a single thread
+	cplex.setParam( IloCplex::Threads, 1 );
+
+	// also limits the root LP of fixByReducedCosts(), optimize() sets it
+	// again as the time limit may change between re-solves
+	cplex.setParam( IloCplex::TiLim, timeLimit );
+}
+
+void tcbvrp_ILP::buildModel()
+{
+	// initialize CPLEX solver, the environment has been created with the object
+	model = IloModel( env );
+
+	if( pairGraphReduction )
+	{
+		delete pairGraph;
+		pairGraph = new PairGraph( instance );
+		unusedArc = IloBoolVar( env, 0, 0 );
+		if( namedVars )
+			unusedArc.setName( "t_unused" );
+		if( !quiet )
+			pairGraph->print( cout );
+	}
+
+	// add model-specific constraints
+	if( model_type == "scf" )
+		modelSCF();
+	else if( model_type == "mcf" )
+		modelMCF();
+	else if( model_type == "mtz" )
+		modelMTZ();
+	else if( model_type == "mcf-benders" )
+		modelMCFBenders();
+	else if( model_type == "tflow" )
+		modelTimeFlow();
+	else
+		throw invalid_argument( "unknown model " + model_type );
+
+	// build model
+	cplex = IloCplex( model );
+	if( quiet )
+	{
+		cplex.setOut( env.getNullStream() );
+		cplex.setWarning( env.getNullStream() );
+	}
+	else
+		printResourceUsage( "model build" );
+
+	// export model to a text file
+	//cplex.exportModel( "model.lp" );
+
+	// set parameters
+	setCPLEXParameters();
+	initAborter();
+
+	if( checkpoint )
+	{
+		string settings = checkpoint->getPath() + ".prm";
+		if( resumeSettings && ifstream( settings.c_str() ).good() )
+			cplex.readParam( settings.c_str() );
+	}
+
+	// the Benders model relies on lazy constraints
+	if( model_type == "mcf-benders" )
+		cplex.setParam( IloCplex::Reduce, 1 );
+}
+
+void tcbvrp_ILP::optimize(double startTime)
+{
+	result.status = IloAlgorithm::Unknown;
+	result.hasSolution = false;
+	cplex.setParam( IloCplex::TiLim, timeLimit );
+
+	// callbacks are installed fresh for every (re-)solve
+	cplex.clearCallbacks();
+
+	// the flow part of the Benders model is added as cuts
+	if( model_type == "mcf-benders" )
+	{
+		cplex.use( IloCplex::Callback( new (env) FlowCutCallbackI( env, *this ) ) );
+		cplex.use( IloCplex::Callback( new (env) FlowUserCutCallbackI( env, *this ) ) );
+	}
+
+	// start local search threads exchanging solutions with CPLEX
+	if( heuristicThreads > 0 && (!heuristic || ownsHeuristic) )
+	{
+		delete heuristic;
+		heuristic = new ConcurrentHeuristic( instance, *pool, heuristicThreads, 0, pairGraph );
+		ownsHeuristic = true;
+	}
+	if( heuristic || pool != &ownPool || checkpoint )
+	{
+		initStartVars();
+		cplex.use( IloCplex::Callback( new (env) InjectionCallbackI( env, *this ) ) );
+	}
+
+	if( hasStartSolution )
+	{
+		pool->offer(startSolution);
+		initStartVars();
+		IloNumArray startValues = solutionToValues(startSolution);
+		cplex.addMIPStart(startVars, startValues);
+		startValues.end();
+		hasStartSolution = false;
+	}
+
+	if( checkpoint )
+		cplex.writeParam( (checkpoint->getPath() + ".prm").c_str() );
+
+	// solve model
+	if( !quiet )
+		cout << "Calling CPLEX solve ...\n";
+	cplex.solve();
+	if( ownsHeuristic )
+		heuristic->stop();
+	storeResult( startTime );
+
+	if( checkpoint )
+	{
+		Solution best;
+		if( pool->getBest(best) || result.hasSolution )
+		{
+			if( result.hasSolution && (best.routes.empty() || result.solution.cost < best.cost) )
+				best = result.solution;
+			checkpoint->save(best, result.bound, true);
+		}
+	}
+
+	if( quiet )
+		return;
+
+	cout << "CPLEX finished." << "\n\n";
+	Solution best;
+	if( heuristic && pool->getBest(best) )
+		cout << "Heuristic objective value: " << best.cost << "\n";
+	cout << "CPLEX status: " << result.status << "\n";
+	cout << "Branch-and-Bound nodes: " << result.nodes << "\n";
+	if( result.hasSolution )
+		cout << "Objective value: " << result.objValue << "\n";
+	cout << "Best bound: " << result.bound << "\n";
+	cout << "Wall time: " << result.time << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n";
+	printResourceUsage( "solve" );
+	cout << "\n";
+
+	if( result.hasSolution )
+		printSolution();
+}
+
+void tcbvrp_ILP::warmStart()
+{
+	// reduced cost fixings of the old data are not valid anymore
+	for(unsigned int v = 0; v < fixedVars.size(); v++)
+		fixedVars[v].first.setUB(fixedVars[v].second);
+	fixedVars.clear();
+
+	// solutions found so far may be infeasible or priced differently now
+	if( pool == &ownPool )
+		ownPool.clear();
+	if( !result.hasSolution )
+		return;
+
+	// the previous solution adapted to the changes is the MIP start, CPLEX
+	// itself keeps the basis of the previous solve for the modified model
+	Solution start = result.solution;
+	LocalSearch ls( instance );
+	if( !ls.repair(start) )
+		return;
+	ls.improve(start);
+	pool->offer(start);
+
+	initStartVars();
+	IloNumArray startValues = solutionToValues(start);
+	cplex.addMIPStart(startVars, startValues);
+	startValues.end();
+}
+
+void tcbvrp_ILP::initAborter()
+{
+	lock_guard<mutex> guard(abortLock);
+	aborter = IloCplex::Aborter( env );
+	cplex.use( aborter );
+	hasAborter = true;
+	// an abort requested during model building stops CPLEX right away
+	if( abortRequested )
+		aborter.abort();
+}
+
+void tcbvrp_ILP::storeResult(double startTime)
+{
+	result.status = cplex.getStatus();
+	result.nodes = cplex.getNnodes();
+	try {
+		result.bound = cplex.getBestObjValue();
+	} catch (IloException &e){
+		// aborted before the root relaxation was solved
+		result.bound = -IloInfinity;
+	}
+	result.hasSolution = result.status == IloAlgorithm::Feasible || result.status == IloAlgorithm::Optimal;
+	if( result.hasSolution )
+	{
+		result.objValue = cplex.getObjValue();
+		IloNumArray values(env);
+		cplex.getValues(values, varBlocks[tBlock].vars);
+		result.solution = valuesToSolution(values);
+		result.solution.evaluate(instance);
+		values.end();
+	}
+	result.time = Tools::wallTime() - startTime;
+}
+
+int tcbvrp_ILP::findVarBlock(string prefix, unsigned int numDims)
+{
+	for(unsigned int b = 0; b < varBlocks.size(); b++)
+	{
+		if( varBlocks[b].prefix == prefix && varBlocks[b].dims.size() == numDims )
+			return b;
+	}
+	return -1;
+}
+
+void tcbvrp_ILP::fixToZero(IloNumVar var, bool permanent)
+{
+	if( !permanent )
+		fixedVars.push_back(make_pair(var, var.getUB()));
+	var.setUB(0);
+}
+
+IloConversion tcbvrp_ILP::addRelaxation()
+{
+	// every variable exactly once, all arcs outside of the pair graph are the same one
+	IloNumVarArray allVars(env);
+	if( pairGraph )
+		allVars.add(unusedArc);
+	for(unsigned int b = 0; b < varBlocks.size(); b++)
+	{
+		for(IloInt col = 0; col < varBlocks[b].vars.getSize(); col++)
+		{
+			if( !isUnusedArc(varBlocks[b].vars[col]) )
+				allVars.add(varBlocks[b].vars[col]);
+		}
+	}
+	IloConversion relaxation(env, allVars, ILOFLOAT);
+	model.add(relaxation);
+	return relaxation;
+}
+
+void tcbvrp_ILP::fixByReducedCosts()
+{
+	/*
+	 * upper bound from the native heuristic, its solution becomes a MIP start
+	 */
+
+	Solution ub;
+	if( !pool->getBest(ub) )
+	{
+		HeuristicSolver heuristicSolver( instance );
+		heuristicSolver.setTimeLimit( min(FIXING_HEURISTIC_TIME, timeLimit / 100) );
+		heuristicSolver.setRecombineInterval( 0 );
+		if( !heuristicSolver.solve( true ) )
+		{
+			if( !quiet )
+				cout << "Reduced cost fixing: no upper bound found\n";
+			return;
+		}
+		ub = heuristicSolver.getSolution();
+		pool->offer(ub);
+	}
+
+	/*
+	 * solve the LP relaxation of the root node
+	 */
+
+	IloConversion relaxation = addRelaxation();
+	cplex.solve();
+	if( cplex.getStatus() != IloAlgorithm::Optimal )
+	{
+		model.remove(relaxation);
+		relaxation.end();
+		return;
+	}
+	IloNum lpBound = cplex.getObjValue();
+
+	IloNumVarArray tVars = varBlocks[tBlock].vars;
+	IloNumArray reducedCosts(env);
+	cplex.getReducedCosts(reducedCosts, tVars);
+
+	model.remove(relaxation);
+	relaxation.end();
+
+	/*
+	 * every solution using arc (j,k) on tour i costs at least lpBound + rc(i,j,k),
+	 * so the arc can be dropped if this exceeds the upper bound
+	 */
+
+	int scfBlock = findVarBlock("f_", 3);
+	int timeFlowBlock = findVarBlock("g_", 3);
+	int mcfBlock = findVarBlock("f_", 4);
+	int mtzBlock = findVarBlock("u_", 2);
+	IloInt numFixed = 0, numCompanions = 0;
+	vector<vector<int> > openInArcs(m, vector<int>(n, 0));
+
+	for(IloInt col = 0; col < tVars.getSize(); col++)
+	{
+		int idx[4];
+		decodeIndices(varBlocks[tBlock], col, idx);
+		int i = idx[0], j = idx[1], k = idx[2];
+
+		if( tVars[col].getUB() == 0 || lpBound + reducedCosts[col] <= ub.cost + 1e-6 )
+		{
+			if( tVars[col].getUB() > 0 )
+				openInArcs[i][k]++;
+			continue;
+		}
+
+		fixToZero(tVars[col]);
+		numFixed++;
+		if( scfBlock >= 0 )
+		{
+			fixToZero(varBlocks[scfBlock].vars[col]);
+			numCompanions++;
+		}
+		if( timeFlowBlock >= 0 )
+		{
+			fixToZero(varBlocks[timeFlowBlock].vars[col]);
+			numCompanions++;
+		}
+		if( mcfBlock >= 0 )
+		{
+			// all commodities on the arc
+			for(unsigned int c = 0; c < n; c++)
+			{
+				fixToZero(varBlocks[mcfBlock].vars[((i*n + c)*n + j)*n + k]);
+				numCompanions++;
+			}
+		}
+	}
+	reducedCosts.end();
+
+	// the order of a node without any usable incoming arc on a tour is 0
+	if( mtzBlock >= 0 )
+	{
+		for(unsigned int i = 0; i < m; i++)
+		{
+			for(unsigned int k = 1; k < n; k++)
+			{
+				if( openInArcs[i][k] == 0 )
+				{
+					fixToZero(varBlocks[mtzBlock].vars[i*n + k]);
+					numCompanions++;
+				}
+			}
+		}
+	}
+
+	initStartVars();
+	IloNumArray startValues = solutionToValues(ub);
+	cplex.addMIPStart(startVars, startValues);
+	startValues.end();
 
-	// only use a single thread
-	cplex.setParam( IloCplex::Threads, 1 );
-	// set time limit for cplex (in seconds)
-	cplex.setParam( IloCplex::TiLim, 3600);
+	if( !quiet )
+		cout << "Reduced cost fixing: LP bound " << lpBound << ", upper bound " << ub.cost
+			<< ", fixed " << numFixed << " of " << tVars.getSize() << " arc variables and "
+			<< numCompanions << " companion columns to 0\n";
 }
 
 void tcbvrp_ILP::initObjectiveFunction(BoolVar3Matrix var_t)
@@ -107,7 +948,8 @@ void tcbvrp_ILP::initObjectiveFunction(BoolVar3Matrix var_t)
 		}
 	}
 
-	model.add(IloMinimize(env, objFunction));
+	objective = IloMinimize(env, objFunction);
+	model.add(objective);
 	objFunction.end();
 }
 
@@ -117,6 +959,7 @@ void tcbvrp_ILP::initDecisionVars(BoolVar3Matrix &var_t, IloBoolVarArray &var_r)
 	 * t(i,j,k) is 1 if the arc from (j,k) is used by the tour i
 	 */
 
+	int block = tBlock = addVarBlock("t_", instance.m, instance.n, instance.n);
 	for(int i=0; i < instance.m; i++)
 	{
 		var_t[i] = BoolVarMatrix(env, instance.n);
@@ -125,7 +968,14 @@ void tcbvrp_ILP::initDecisionVars(BoolVar3Matrix &var_t, IloBoolVarArray &var_r)
 			var_t[i][j] = IloBoolVarArray(env, instance.n);
 			for(int k=0; k < instance.n; k++)
 			{
-				var_t[i][j][k] = IloBoolVar(env, Tools::indicesToString( "t_", i, j, k).c_str());
+				if( !hasArc(j, k) )
+				{
+					var_t[i][j][k] = unusedArc;
+					varBlocks[block].vars.add(unusedArc);
+					continue;
+				}
+				var_t[i][j][k] = IloBoolVar(env);
+				registerVar(block, var_t[i][j][k], i, j, k);
 			}
 		}
 	}
@@ -134,9 +984,11 @@ void tcbvrp_ILP::initDecisionVars(BoolVar3Matrix &var_t, IloBoolVarArray &var_r)
 	 * additional variables n(i) represent the number of nodes in the tour i
 	 */
 
+	block = addVarBlock("r_", instance.m);
 	for(int i=0; i < instance.m; i++)
 	{
-		var_r[i] = IloBoolVar(env, Tools::indicesToString( "r_", i).c_str());
+		var_r[i] = IloBoolVar(env);
+		registerVar(block, var_r[i], i);
 	}
 }
 
@@ -161,13 +1013,33 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 	 * there are only other arcs if there is an outgoing arc from the originator
 	 */
 
-	 for(int i=0;i<instance.m;i++)
+	 if( buildThreads > 1 )
 	 {
-	 	for(int j=1; j < instance.n; j++)
+	 	int rBlock = findVarBlock("r_", 1);
+	 	addRows(instance.m * instance.n, [this, rBlock](long outer, RowAssembler::Rows& rows) {
+	 		int i = outer / instance.n, j = outer % instance.n;
+	 		for(int k=1; j > 0 && k < instance.n; k++)
+	 		{
+	 			if(!hasArc(j, k))
+	 				continue;
+	 			rows.begin(-IloInfinity, 0);
+	 			rows.add(encodeColumn(tBlock, i, j, k), 1);
+	 			rows.add(encodeColumn(rBlock, i), -1);
+	 			rows.end();
+	 		}
+	 	});
+	 }
+	 else
+	 {
+	 	for(int i=0;i<instance.m;i++)
 	 	{
-	 		for(int k=1; k < instance.n; k++)
+	 		for(int j=1; j < instance.n; j++)
 	 		{
-	 			model.add(var_t[i][j][k] <= var_r[i]);
+	 			for(int k=1; k < instance.n; k++)
+	 			{
+	 				if(hasArc(j, k))
+	 					model.add(var_t[i][j][k] <= var_r[i]);
+	 			}
 	 		}
 	 	}
 	 }
@@ -180,9 +1052,11 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 	 }
 
 	 IloBoolVarArray var_s(env,instance.n);
+	 int block = addVarBlock("s_", instance.n);
 	 for(int i=0; i < instance.n; i++)
 	 {
-	 	var_s[i] = IloBoolVar(env, Tools::indicesToString( "s_", i).c_str());
+	 	var_s[i] = IloBoolVar(env);
+	 	registerVar(block, var_s[i], i);
 	 }
 
 
@@ -210,7 +1084,8 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
  	{
  		exprSumVarS += var_s[k];
  	}
- 	model.add(exprSumVarS == iNumDemandNodes);
+ 	supplyCountRow = (exprSumVarS == instance.numRequiredDemands());
+ 	model.add(supplyCountRow);
  	exprSumVarS.end();
 
 
@@ -249,33 +1124,59 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 	 * the originator is not allowed to got to a demand node
 	 * a supply node is not allowed to got to the originator
 	 * no self loops are allowed
+	 *
+	 * the pair graph does not contain any of these arcs
 	 */
 
-	 for(int k=0; k < instance.m; k++)
+	 if( buildThreads > 1 && !pairGraph )
 	 {
-	 	for(int i=0;i<instance.n;i++)
+	 	// the parallel build fixes these arcs by their bounds instead of a row per rule,
+	 	// the node types do not change with the instance, so warmStart() keeps them
+	 	for(int k=0; k < instance.m; k++)
 	 	{
-	 		for(int j=0; j< instance.n; j++)
+	 		for(int i=0;i<instance.n;i++)
 	 		{
-	 			if(instance.isSupplyNode(i) && instance.isSupplyNode(j))
+	 			for(int j=0; j< instance.n; j++)
 	 			{
-	 				model.add(var_t[k][i][j] == 0);
-	 			}
-	 			if(instance.isDemandNode(i) && instance.isDemandNode(j))
-	 			{
-	 				model.add(var_t[k][i][j] == 0);
-	 			}
-	 			if(i==0 && instance.isDemandNode(j))
-	 			{
-	 				model.add(var_t[k][i][j] == 0);
-	 			}
-	 			if(instance.isSupplyNode(i) && j==0)
-	 			{
-	 				model.add(var_t[k][i][j] == 0);
+	 				if((instance.isSupplyNode(i) && instance.isSupplyNode(j)) ||
+	 					(instance.isDemandNode(i) && instance.isDemandNode(j)) ||
+	 					(i==0 && instance.isDemandNode(j)) ||
+	 					(instance.isSupplyNode(i) && j==0) || i==j)
+	 				{
+	 					fixToZero(var_t[k][i][j], true);
+	 				}
 	 			}
-	 			if(i==j)
+	 		}
+	 	}
+	 }
+	 else
+	 {
+	 	for(int k=0; k < instance.m && !pairGraph; k++)
+	 	{
+	 		for(int i=0;i<instance.n;i++)
+	 		{
+	 			for(int j=0; j< instance.n; j++)
 	 			{
-	 				model.add(var_t[k][i][j] == 0);
+	 				if(instance.isSupplyNode(i) && instance.isSupplyNode(j))
+	 				{
+	 					model.add(var_t[k][i][j] == 0);
+	 				}
+	 				if(instance.isDemandNode(i) && instance.isDemandNode(j))
+	 				{
+	 					model.add(var_t[k][i][j] == 0);
+	 				}
+	 				if(i==0 && instance.isDemandNode(j))
+	 				{
+	 					model.add(var_t[k][i][j] == 0);
+	 				}
+	 				if(instance.isSupplyNode(i) && j==0)
+	 				{
+	 					model.add(var_t[k][i][j] == 0);
+	 				}
+	 				if(i==j)
+	 				{
+	 					model.add(var_t[k][i][j] == 0);
+	 				}
 	 			}
 	 		}
 	 	}
@@ -285,6 +1186,7 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 	 * Each demand node has to have an outgoing arc which goes to a supply node or the originator
 	 */
 
+	coverRows.resize(instance.n);
 	for(int j=1; j< instance.n; j++)
 	{
 		if(instance.isDemandNode(j))
@@ -300,7 +1202,9 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 					}
 				}
 			}
-			model.add(toSupplyExpr == 1);
+			// cancelled demand nodes are not visited at all
+			coverRows[j] = (toSupplyExpr == (instance.isRequired(j) ? 1 : 0));
+			model.add(coverRows[j]);
 			toSupplyExpr.end();
 		}
 	}
@@ -382,9 +1286,11 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 
 	/*
 	 * A tour must be finished under the maximum time
+	 *
+	 * the time-flow model enforces this on the arcs back to the depot
 	 */
 
-	for(int i=0;i<instance.m;i++)
+	for(int i=0;i<instance.m && model_type != "tflow";i++)
 	{
 		IloExpr maxTimeExpr(env);
 		for(int j=0;j<instance.n;j++)
@@ -394,7 +1300,8 @@ void tcbvrp_ILP::initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r){
 				maxTimeExpr += var_t[i][j][k] * instance.getDistance(j, k);
 			}
 		}
-		model.add(maxTimeExpr <= instance.T);
+		timeRows.push_back(maxTimeExpr <= instance.T);
+		model.add(timeRows.back());
 		maxTimeExpr.end();
 	}
 }
@@ -406,6 +1313,7 @@ void tcbvrp_ILP::modelSCF()
 	 */
 
 	NumVar3Matrix var_f(env,instance.m);
+	int block = addVarBlock("f_", instance.m, instance.n, instance.n);
 	for(int i=0; i < instance.m; i++)
 	{
 		var_f[i] = NumVarMatrix(env, instance.n);
@@ -414,7 +1322,14 @@ void tcbvrp_ILP::modelSCF()
 			var_f[i][j] = IloNumVarArray(env, instance.n);
 			for(int k=0; k < instance.n; k++)
 			{
-				var_f[i][j][k] = IloNumVar(env, Tools::indicesToString( "f_", i, j, k).c_str());
+				if( !hasArc(j, k) )
+				{
+					var_f[i][j][k] = unusedArc;
+					varBlocks[block].vars.add(unusedArc);
+					continue;
+				}
+				var_f[i][j][k] = IloNumVar(env);
+				registerVar(block, var_f[i][j][k], i, j, k);
 			}
 		}
 	}
@@ -456,26 +1371,53 @@ void tcbvrp_ILP::modelSCF()
 	 * Leaving one commodity on each node.
 	 */
 
-	for(int i=0;i<instance.m;i++)
+	if( buildThreads > 1 )
 	{
-		for(int j=1;j<instance.n;j++)
-		{
-			IloExpr incomingExpr(env);
-			IloExpr outgoingExpr(env);
-			IloExpr edgeinExpr(env);
+		// arcs outside of the pair graph are fixed to 0 and left out of all assembled rows
+		addRows(instance.m * instance.n, [this, block](long outer, RowAssembler::Rows& rows) {
+			int i = outer / instance.n, j = outer % instance.n;
+			if(j == 0)
+				return;
+			rows.begin(0, 0);
 			for(int k=0; k < instance.n; k++)
 			{
-				if(j!=k)
+				if(j!=k && hasArc(k, j))
+				{
+					rows.add(encodeColumn(block, i, k, j), 1);
+					rows.add(encodeColumn(tBlock, i, k, j), -0.5);
+				}
+				if(j!=k && hasArc(j, k))
+				{
+					rows.add(encodeColumn(block, i, j, k), -1);
+					rows.add(encodeColumn(tBlock, i, j, k), -0.5);
+				}
+			}
+			rows.end();
+		});
+	}
+	else
+	{
+		for(int i=0;i<instance.m;i++)
+		{
+			for(int j=1;j<instance.n;j++)
+			{
+				IloExpr incomingExpr(env);
+				IloExpr outgoingExpr(env);
+				IloExpr edgeinExpr(env);
+				for(int k=0; k < instance.n; k++)
 				{
-					incomingExpr += var_f[i][k][j];
-					outgoingExpr += var_f[i][j][k];
-					edgeinExpr += var_t[i][k][j] + var_t[i][j][k];
+					if(j!=k)
+					{
+						incomingExpr += var_f[i][k][j];
+						outgoingExpr += var_f[i][j][k];
+						edgeinExpr += var_t[i][k][j] + var_t[i][j][k];
+					}
 				}
+				model.add(incomingExpr - outgoingExpr == (edgeinExpr)/2);
+				incomingExpr.end();
+				outgoingExpr.end();
+				edgeinExpr.end();
 			}
-			model.add(incomingExpr - outgoingExpr == (edgeinExpr)/2);
-			incomingExpr.end();
-			outgoingExpr.end();
-			edgeinExpr.end();
 		}
 	}
 
@@ -483,18 +1425,36 @@ void tcbvrp_ILP::modelSCF()
 	 * the flow must be greater or equal than 0 for all routes
 	 */
 
-	for(int i=0;i<instance.m;i++)
+	if( buildThreads > 1 )
 	{
-		for(int j=0;j<instance.n;j++)
-		{
+		addRows(instance.m * instance.n, [this, block](long outer, RowAssembler::Rows& rows) {
+			int i = outer / instance.n, j = outer % instance.n;
 			for(int k=0; k < instance.n; k++)
 			{
-				if(j!=k)
+				if(j!=k && hasArc(j, k))
+				{
+					rows.begin(0, IloInfinity);
+					rows.add(encodeColumn(block, i, j, k), 1);
+					rows.end();
+				}
+			}
+		});
+	}
+	else
+	{
+		for(int i=0;i<instance.m;i++)
+		{
+			for(int j=0;j<instance.n;j++)
+			{
+				for(int k=0; k < instance.n; k++)
 				{
-					IloExpr flowExpr(env);
-					flowExpr += var_f[i][j][k];
-					model.add(flowExpr >= 0);
-					flowExpr.end();
+					if(j!=k && hasArc(j, k))
+					{
+						IloExpr flowExpr(env);
+						flowExpr += var_f[i][j][k];
+						model.add(flowExpr >= 0);
+						flowExpr.end();
+					}
 				}
 			}
 		}
@@ -504,21 +1464,40 @@ void tcbvrp_ILP::modelSCF()
 	 * the flow must be smaller than the number of hops
 	 */
 
-	for(int i=0;i<instance.m;i++)
+	if( buildThreads > 1 )
 	{
-		for(int j=0;j<instance.n;j++)
-		{
+		addRows(instance.m * instance.n, [this, block](long outer, RowAssembler::Rows& rows) {
+			int i = outer / instance.n, j = outer % instance.n;
 			for(int k=0; k < instance.n; k++)
 			{
-				if(j!=k)
+				if(j!=k && hasArc(j, k))
+				{
+					rows.begin(-IloInfinity, 0);
+					rows.add(encodeColumn(block, i, j, k), 1);
+					rows.add(encodeColumn(tBlock, i, j, k), -instance.n);
+					rows.end();
+				}
+			}
+		});
+	}
+	else
+	{
+		for(int i=0;i<instance.m;i++)
+		{
+			for(int j=0;j<instance.n;j++)
+			{
+				for(int k=0; k < instance.n; k++)
 				{
-					IloExpr flow1Expr(env);
-					IloExpr flow2Expr(env);
-					flow1Expr += var_f[i][j][k];
-					flow2Expr += var_t[i][j][k];
-					model.add(flow1Expr <= instance.n * flow2Expr);
-					flow1Expr.end();
-					flow2Expr.end();
+					if(j!=k && hasArc(j, k))
+					{
+						IloExpr flow1Expr(env);
+						IloExpr flow2Expr(env);
+						flow1Expr += var_f[i][j][k];
+						flow2Expr += var_t[i][j][k];
+						model.add(flow1Expr <= instance.n * flow2Expr);
+						flow1Expr.end();
+						flow2Expr.end();
+					}
 				}
 			}
 		}
@@ -532,12 +1511,14 @@ void tcbvrp_ILP::modelMTZ()
 	 */
 
 	NumVarMatrix var_u(env,instance.m);
+	int block = addVarBlock("u_", instance.m, instance.n);
 	for(int i=0; i < instance.m; i++)
 	{
 		var_u[i] = IloNumVarArray(env, instance.n);
 		for(int k=0; k < instance.n; k++)
 		{
-			var_u[i][k] = IloNumVar(env, Tools::indicesToString( "u_", i, k).c_str());
+			var_u[i][k] = IloNumVar(env);
+			registerVar(block, var_u[i][k], i, k);
 		}
 	}
 
@@ -586,6 +1567,9 @@ void tcbvrp_ILP::modelMTZ()
 		{
 			for(int k=1;(k<instance.n);k++)
 			{
+				// the order only matters along arcs which can be used
+				if(!hasArc(j, k))
+					continue;
 				IloExpr uLeftExpr(env);
 				IloExpr uRightExpr(env);
 				uLeftExpr += var_u[i][j] - var_u[i][k] + 1;
@@ -605,6 +1589,7 @@ void tcbvrp_ILP::modelMCF()
 	 */
 
 	 NumVar4Matrix var_f(env,instance.m);
+	 int block = addVarBlock("f_", instance.m, instance.n, instance.n, instance.n);
 	 for(int l=0; l < instance.m; l++)
 	 {
 	 	var_f[l] = NumVar3Matrix(env, instance.n);
@@ -616,7 +1601,14 @@ void tcbvrp_ILP::modelMCF()
 	 			var_f[l][i][j] = IloNumVarArray(env, instance.n);
 	 			for(int k=0; k < instance.n; k++)
 	 			{
-	 				var_f[l][i][j][k] = IloNumVar(env, Tools::indicesToString( "f_", i, j, k).c_str());
+	 				if( !hasArc(j, k) )
+	 				{
+	 					var_f[l][i][j][k] = unusedArc;
+	 					varBlocks[block].vars.add(unusedArc);
+	 					continue;
+	 				}
+	 				var_f[l][i][j][k] = IloNumVar(env);
+	 				registerVar(block, var_f[l][i][j][k], l, i, j, k);
 	 			}
 	 		}
 	 	}
@@ -636,27 +1628,52 @@ void tcbvrp_ILP::modelMCF()
 	 * assign one commodity to every used node
 	 */
 
-	 for(int k=1; k < instance.n; k++)
+	 if( buildThreads > 1 )
 	 {
-	 	for(int l=0;l<instance.m;l++)
-	 	{
-	 		IloExpr incomingExpr(env);
-	 		IloExpr outgoingExpr(env);
-	 		IloExpr edgeinExpr(env);
-	 	//	IloExpr edgeoutExpr(env);
+	 	// arcs outside of the pair graph are fixed to 0 and left out of all assembled rows
+	 	addRows(instance.n * instance.m, [this, block](long outer, RowAssembler::Rows& rows) {
+	 		int k = outer / instance.m, l = outer % instance.m;
+	 		if(k == 0)
+	 			return;
+	 		rows.begin(0, 0);
 	 		for(int j=1;j<instance.n;j++)
 	 		{
-	 			incomingExpr += var_f[l][k][0][j];
-	 			outgoingExpr += var_f[l][k][j][0];
-	 			edgeinExpr += var_t[l][j][k] + var_t[l][k][j];
-	 	//		edgeoutExpr += var_t[l][k][j];
+	 			if(hasArc(0, j))
+	 				rows.add(encodeColumn(block, l, k, 0, j), 1);
+	 			if(hasArc(j, 0))
+	 				rows.add(encodeColumn(block, l, k, j, 0), -1);
+	 			if(hasArc(j, k))
+	 				rows.add(encodeColumn(tBlock, l, j, k), -0.5);
+	 			if(hasArc(k, j))
+	 				rows.add(encodeColumn(tBlock, l, k, j), -0.5);
+	 		}
+	 		rows.end();
+	 	});
+	 }
+	 else
+	 {
+	 	for(int k=1; k < instance.n; k++)
+	 	{
+	 		for(int l=0;l<instance.m;l++)
+	 		{
+	 			IloExpr incomingExpr(env);
+	 			IloExpr outgoingExpr(env);
+	 			IloExpr edgeinExpr(env);
+	 		//	IloExpr edgeoutExpr(env);
+	 			for(int j=1;j<instance.n;j++)
+	 			{
+	 				incomingExpr += var_f[l][k][0][j];
+	 				outgoingExpr += var_f[l][k][j][0];
+	 				edgeinExpr += var_t[l][j][k] + var_t[l][k][j];
+	 		//		edgeoutExpr += var_t[l][k][j];
+	 			}
+	 			model.add(incomingExpr - outgoingExpr == edgeinExpr/2);
+	 		//	model.add(outgoingExpr - incomingExpr == edgeoutExpr);
+	 			incomingExpr.end();
+	 			outgoingExpr.end();
+	 			edgeinExpr.end();
+	 		//	edgeoutExpr.end();
 	 		}
-	 		model.add(incomingExpr - outgoingExpr == edgeinExpr/2);
-	 	//	model.add(outgoingExpr - incomingExpr == edgeoutExpr);
-	 		incomingExpr.end();
-	 		outgoingExpr.end();
-	 		edgeinExpr.end();
-	 	//	edgeoutExpr.end();
 	 	}
 	 }
 
@@ -664,28 +1681,48 @@ void tcbvrp_ILP::modelMCF()
 	 * Sending out 1 commodity for every used node from the originator
 	 */
 
-	 for(int k=1; k < instance.n; k++)
+	 if( buildThreads > 1 )
 	 {
-	 	for(int l=0;l<instance.m;l++)
-	 	{
-	 		IloExpr myflowExpr(env);
-	 		IloExpr edgeinExpr(env);
-	 	//	IloExpr edgeoutExpr(env);
+	 	addRows(instance.n * instance.m, [this, block](long outer, RowAssembler::Rows& rows) {
+	 		int k = outer / instance.m, l = outer % instance.m;
+	 		if(k == 0)
+	 			return;
+	 		rows.begin(0, 0);
 	 		for(int i=0;i<instance.n;i++)
 	 		{
-	 			if(i!=k)
+	 			if(i!=k && hasArc(i, k))
+	 				rows.add(encodeColumn(block, l, k, i, k), 1);
+	 			if(hasArc(i, k))
+	 				rows.add(encodeColumn(tBlock, l, i, k), -1);
+	 		}
+	 		rows.end();
+	 	});
+	 }
+	 else
+	 {
+	 	for(int k=1; k < instance.n; k++)
+	 	{
+	 		for(int l=0;l<instance.m;l++)
+	 		{
+	 			IloExpr myflowExpr(env);
+	 			IloExpr edgeinExpr(env);
+	 		//	IloExpr edgeoutExpr(env);
+	 			for(int i=0;i<instance.n;i++)
 	 			{
-	 				myflowExpr += var_f[l][k][i][k];
-	 			}
+	 				if(i!=k)
+	 				{
+	 					myflowExpr += var_f[l][k][i][k];
+	 				}
 
-	 			edgeinExpr += var_t[l][i][k];
-	 	//		edgeoutExpr += var_t[l][k][i];
+	 				edgeinExpr += var_t[l][i][k];
+	 		//		edgeoutExpr += var_t[l][k][i];
+	 			}
+	 			model.add(myflowExpr == edgeinExpr);
+	 		//	model.add(myflowExpr == edgeoutExpr);
+	 			myflowExpr.end();
+	 			edgeinExpr.end();
+	 		//	edgeoutExpr.end();
 	 		}
-	 		model.add(myflowExpr == edgeinExpr);
-	 	//	model.add(myflowExpr == edgeoutExpr);
-	 		myflowExpr.end();
-	 		edgeinExpr.end();
-	 	//	edgeoutExpr.end();
 	 	}
 	 }
 
@@ -693,27 +1730,50 @@ void tcbvrp_ILP::modelMCF()
 	 * no node takes a commodity not assigned to it
 	 */
 
-	 for(int k=1; k < instance.n; k++)
+	 if( buildThreads > 1 )
 	 {
-	 	for(int j=1;j<instance.n;j++)
-	 	{
+	 	addRows(instance.n * instance.n, [this, block](long outer, RowAssembler::Rows& rows) {
+	 		int k = outer / instance.n, j = outer % instance.n;
+	 		if(k == 0 || j == 0 || j == k)
+	 			return;
 	 		for(int l=0;l<instance.m;l++)
 	 		{
-	 			if(j!=k)
+	 			rows.begin(0, 0);
+	 			for(int i=0;i<instance.n;i++)
+	 			{
+	 				if(i!=j && hasArc(i, j))
+	 					rows.add(encodeColumn(block, l, k, i, j), 1);
+	 				if(i!=j && hasArc(j, i))
+	 					rows.add(encodeColumn(block, l, k, j, i), -1);
+	 			}
+	 			rows.end();
+	 		}
+	 	});
+	 }
+	 else
+	 {
+	 	for(int k=1; k < instance.n; k++)
+	 	{
+	 		for(int j=1;j<instance.n;j++)
+	 		{
+	 			for(int l=0;l<instance.m;l++)
 	 			{
-	 				IloExpr incomingExpr(env);
-	 				IloExpr outgoingExpr(env);
-	 				for(int i=0;i<instance.n;i++)
+	 				if(j!=k)
 	 				{
-	 					if(i!=j)
+	 					IloExpr incomingExpr(env);
+	 					IloExpr outgoingExpr(env);
+	 					for(int i=0;i<instance.n;i++)
 	 					{
-	 						incomingExpr += var_f[l][k][i][j];
-	 						outgoingExpr += var_f[l][k][j][i];
+	 						if(i!=j)
+	 						{
+	 							incomingExpr += var_f[l][k][i][j];
+	 							outgoingExpr += var_f[l][k][j][i];
+	 						}
 	 					}
+	 					model.add(incomingExpr - outgoingExpr == 0);
+	 					incomingExpr.end();
+	 					outgoingExpr.end();
 	 				}
-	 				model.add(incomingExpr - outgoingExpr == 0);
-	 				incomingExpr.end();
-	 				outgoingExpr.end();
 	 			}
 	 		}
 	 	}
@@ -722,20 +1782,41 @@ void tcbvrp_ILP::modelMCF()
 	/*
 	 * the flow must be greater or equal than 0 for all routes
 	 */
-	 for(int k=1; k < instance.n; k++)
+	 if( buildThreads > 1 )
 	 {
-	 	for(int i=0;i<instance.n;i++)
-	 	{
-	 		for(int j=0;j<instance.n;j++)
+	 	addRows(instance.n * instance.n, [this, block](long outer, RowAssembler::Rows& rows) {
+	 		int k = outer / instance.n, i = outer % instance.n;
+	 		for(int j=0;j<instance.n && k > 0;j++)
 	 		{
 	 			for(int l=0;l<instance.m;l++)
 	 			{
-	 				if(j!=i)
+	 				if(j!=i && hasArc(i, j))
+	 				{
+	 					rows.begin(0, IloInfinity);
+	 					rows.add(encodeColumn(block, l, k, i, j), 1);
+	 					rows.end();
+	 				}
+	 			}
+	 		}
+	 	});
+	 }
+	 else
+	 {
+	 	for(int k=1; k < instance.n; k++)
+	 	{
+	 		for(int i=0;i<instance.n;i++)
+	 		{
+	 			for(int j=0;j<instance.n;j++)
+	 			{
+	 				for(int l=0;l<instance.m;l++)
 	 				{
-	 					IloExpr flowExpr(env);
-	 					flowExpr += var_f[l][k][i][j];
-	 					model.add(flowExpr >= 0);
-	 					flowExpr.end();
+	 					if(j!=i && hasArc(i, j))
+	 					{
+	 						IloExpr flowExpr(env);
+	 						flowExpr += var_f[l][k][i][j];
+	 						model.add(flowExpr >= 0);
+	 						flowExpr.end();
+	 					}
 	 				}
 	 			}
 	 		}
@@ -746,26 +1827,269 @@ void tcbvrp_ILP::modelMCF()
 	 * the flow must be zero if the node is not used and 1 otherwise
 	 */
 
-	 for(int k=1; k < instance.n; k++)
+	 if( buildThreads > 1 )
 	 {
-	 	for(int i=0;i<instance.n;i++)
-	 	{
-	 		for(int j=0;j<instance.n;j++)
+	 	addRows(instance.n * instance.n, [this, block](long outer, RowAssembler::Rows& rows) {
+	 		int k = outer / instance.n, i = outer % instance.n;
+	 		for(int j=0;j<instance.n && k > 0;j++)
 	 		{
-	 			if(j!=i)
+	 			if(j!=i && hasArc(i, j))
 	 			{
 	 				for(int l=0;l<instance.m;l++)
 	 				{
-	 					IloExpr flowExpr(env);
-	 					IloExpr conExpr(env);
-	 					flowExpr += var_f[l][k][i][j];
-	 					conExpr += var_t[l][i][j];
-	 					model.add(flowExpr <= conExpr);
-	 					conExpr.end();
-	 					flowExpr.end();
+	 					rows.begin(-IloInfinity, 0);
+	 					rows.add(encodeColumn(block, l, k, i, j), 1);
+	 					rows.add(encodeColumn(tBlock, l, i, j), -1);
+	 					rows.end();
+	 				}
+	 			}
+	 		}
+	 	});
+	 }
+	 else
+	 {
+	 	for(int k=1; k < instance.n; k++)
+	 	{
+	 		for(int i=0;i<instance.n;i++)
+	 		{
+	 			for(int j=0;j<instance.n;j++)
+	 			{
+	 				if(j!=i && hasArc(i, j))
+	 				{
+	 					for(int l=0;l<instance.m;l++)
+	 					{
+	 						IloExpr flowExpr(env);
+	 						IloExpr conExpr(env);
+	 						flowExpr += var_f[l][k][i][j];
+	 						conExpr += var_t[l][i][j];
+	 						model.add(flowExpr <= conExpr);
+	 						conExpr.end();
+	 						flowExpr.end();
+	 					}
 	 				}
 	 			}
 	 		}
 	 	}
 	 }
 }
+
+void tcbvrp_ILP::modelMCFBenders()
+{
+	/*
+	 * master problem: only the arc variables, the flow variables of modelMCF()
+	 * are projected out and replaced by the cuts of separateFlowCuts()
+	 */
+
+	BoolVar3Matrix var_t(env,instance.m);
+	IloBoolVarArray var_r(env,instance.m);
+	initDecisionVars(var_t,var_r);
+	initObjectiveFunction(var_t);
+	initConstraints(var_t,var_r);
+}
+
+void tcbvrp_ILP::modelTimeFlow()
+{
+	/*
+	 * g(i,j,k) is the time at which tour i arrives at k over the arc (j,k), it
+	 * grows by the travel time of every arc, which rules out subtours (all
+	 * travel times between stations are positive) and bounds the tour length
+	 */
+
+	NumVar3Matrix var_g(env,instance.m);
+	int block = addVarBlock("g_", instance.m, instance.n, instance.n);
+	for(int i=0; i < instance.m; i++)
+	{
+		var_g[i] = NumVarMatrix(env, instance.n);
+		for(int j=0; j < instance.n; j++)
+		{
+			var_g[i][j] = IloNumVarArray(env, instance.n);
+			for(int k=0; k < instance.n; k++)
+			{
+				if( !hasArc(j, k) )
+				{
+					var_g[i][j][k] = unusedArc;
+					varBlocks[block].vars.add(unusedArc);
+					continue;
+				}
+				var_g[i][j][k] = IloNumVar(env);
+				registerVar(block, var_g[i][j][k], i, j, k);
+			}
+		}
+	}
+
+	BoolVar3Matrix var_t(env,instance.m);
+	IloBoolVarArray var_r(env,instance.m);
+	initDecisionVars(var_t,var_r);
+	initObjectiveFunction(var_t);
+	initConstraints(var_t,var_r);
+
+	/*
+	 * the time leaving a node is the time arriving there plus the travel time
+	 * of the outgoing arc, tours start at time 0 at the depot
+	 */
+
+	timeFlowRows.clear();
+	for(int i=0;i<instance.m;i++)
+	{
+		for(int v=0;v<instance.n;v++)
+		{
+			IloExpr timeExpr(env);
+			for(int k=0;k<instance.n;k++)
+			{
+				if(k==v)
+					continue;
+				timeExpr += var_g[i][v][k] - instance.getDistance(v, k) * var_t[i][v][k];
+				if(v!=0)
+					timeExpr -= var_g[i][k][v];
+			}
+			timeFlowRows.push_back(timeExpr == 0);
+			model.add(timeFlowRows.back());
+			timeExpr.end();
+		}
+	}
+
+	/*
+	 * time windows of the arcs: not earlier than the shortest way from the
+	 * depot allows and early enough to get back within the time limit, the
+	 * arcs back to the depot carry the tour length
+	 */
+
+	vector<double> earliest, remaining;
+	timeWindows(earliest, remaining);
+	timeFlowArcs.clear();
+	for(int i=0;i<instance.m;i++)
+	{
+		for(int j=0;j<instance.n;j++)
+		{
+			for(int k=0;k<instance.n;k++)
+			{
+				if(j==k || !hasArc(j, k))
+					continue;
+				TimeFlowArc arc;
+				arc.l = i;
+				arc.j = j;
+				arc.k = k;
+				arc.x = var_t[i][j][k];
+				arc.lower = (var_g[i][j][k] - (earliest[j] + instance.getDistance(j, k)) * var_t[i][j][k] >= 0);
+				arc.upper = (var_g[i][j][k] - (instance.T - remaining[k]) * var_t[i][j][k] <= 0);
+				model.add(arc.lower);
+				model.add(arc.upper);
+				timeFlowArcs.push_back(arc);
+			}
+		}
+	}
+}
+
+void tcbvrp_ILP::timeWindows(vector<double>& earliest, vector<double>& remaining)
+{
+	/*
+	 * shortest alternating ways from the depot to every node (arriving at a
+	 * supply node from the depot or a demand node, at a demand node from a
+	 * supply node) and from every node back to the depot
+	 */
+
+	earliest.assign(n, IloInfinity);
+	remaining.assign(n, IloInfinity);
+	earliest[0] = remaining[0] = 0;
+	for(unsigned int k = 1; k < n; k++)
+	{
+		if( instance.isSupplyNode(k) )
+			earliest[k] = instance.getDistance(0, k);
+		else
+			remaining[k] = instance.getDistance(k, 0);
+	}
+
+	bool changed = true;
+	for(unsigned int round = 0; round < n && changed; round++)
+	{
+		changed = false;
+		for(unsigned int j = 1; j < n; j++)
+		{
+			for(unsigned int k = 1; k < n; k++)
+			{
+				if( j == k || instance.isSupplyNode(j) == instance.isSupplyNode(k) )
+					continue;
+				if( earliest[j] + instance.getDistance(j, k) < earliest[k] )
+				{
+					earliest[k] = earliest[j] + instance.getDistance(j, k);
+					changed = true;
+				}
+				if( instance.getDistance(j, k) + remaining[k] < remaining[j] )
+				{
+					remaining[j] = instance.getDistance(j, k) + remaining[k];
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// nodes which cannot be part of any tour get windows closing all their arcs
+	for(unsigned int v = 1; v < n; v++)
+	{
+		earliest[v] = min(earliest[v], (double) instance.T + 1);
+		remaining[v] = min(remaining[v], (double) instance.T + 1);
+	}
+}
+
+void tcbvrp_ILP::updateTimeFlowBounds()
+{
+	vector<double> earliest, remaining;
+	timeWindows(earliest, remaining);
+	for(unsigned int a = 0; a < timeFlowArcs.size(); a++)
+	{
+		TimeFlowArc& arc = timeFlowArcs[a];
+		arc.lower.setLinearCoef(arc.x, -(earliest[arc.j] + instance.getDistance(arc.j, arc.k)));
+		arc.upper.setLinearCoef(arc.x, -(instance.T - remaining[arc.k]));
+	}
+}
+
+void tcbvrp_ILP::separateFlowCuts(IloEnv cbEnv, const IloNumArray& tValues, IloNum minViolation, vector<IloRange>& cuts)
+{
+	/*
+	 * commodity k of tour l can be routed from the depot iff the max flow from
+	 * 0 to k with capacities t(l,i,j) reaches the inflow of k. Otherwise the
+	 * minimum cut S gives the feasibility cut
+	 *   sum_{i in S, j not in S} t(l,i,j) >= sum_i t(l,i,k)
+	 */
+
+	IloNumVarArray tVars = varBlocks[tBlock].vars;
+	for(unsigned int l = 0; l < m; l++)
+	{
+		for(unsigned int k = 1; k < n; k++)
+		{
+			IloNum inflow = 0;
+			for(unsigned int i = 0; i < n; i++)
+				inflow += tValues[(l*n + i)*n + k];
+			if( inflow < minViolation )
+				continue;
+
+			MaxFlow maxFlow(n);
+			for(unsigned int i = 0; i < n; i++)
+			{
+				for(unsigned int j = 0; j < n; j++)
+				{
+					if( i != j )
+						maxFlow.setCapacity(i, j, tValues[(l*n + i)*n + j]);
+				}
+			}
+			if( maxFlow.solve(0, k, inflow) >= inflow - minViolation )
+				continue;
+
+			IloExpr cutExpr(cbEnv);
+			for(unsigned int i = 0; i < n; i++)
+			{
+				if( !maxFlow.isSourceSide(i) )
+					continue;
+				for(unsigned int j = 0; j < n; j++)
+				{
+					if( !maxFlow.isSourceSide(j) )
+						cutExpr += tVars[(l*n + i)*n + j];
+				}
+			}
+			for(unsigned int i = 0; i < n; i++)
+				cutExpr -= tVars[(l*n + i)*n + k];
+			cuts.push_back(cutExpr >= 0);
+			cutExpr.end();
+		}
+	}
+}
@@ -3,6 +3,13 @@
 
 #include "Tools.h"
 #include "Instance.h"
+#include "Solution.h"
+#include "ConcurrentHeuristic.h"
+#include "HeuristicSolver.h"
+#include "MaxFlow.h"
+#include "PairGraph.h"
+#include "Checkpoint.h"
+#include "RowAssembler.h"
 #include <ilcplex/ilocplex.h>
 
 using namespace std;
@@ -24,8 +31,97 @@ class tcbvrp_ILP
 
 private:
 
+	/*
+	 * all variables of one family (t_, r_, f_, ...) in row-major order, so that
+	 * a column index can be decoded back into its indices without names
+	 */
+	struct VarBlock
+	{
+		string prefix;
+		vector<int> dims;
+		IloNumVarArray vars;
+	};
+
+	/*
+	 * exchanges solutions between CPLEX and the heuristic workers: new incumbents
+	 * and every few nodes the rounded LP solution are handed to the workers,
+	 * improved solutions of the workers are injected as new incumbents
+	 */
+	class InjectionCallbackI : public IloCplex::HeuristicCallbackI
+	{
+		tcbvrp_ILP& ilp;
+		IloNum lastIncumbent;
+		IloNum lastInjected;
+		IloInt calls;
+	public:
+		InjectionCallbackI( IloEnv env, tcbvrp_ILP& _ilp );
+		IloCplex::CallbackI* duplicateCallback() const;
+		void main();
+	};
+
+	/*
+	 * Benders feasibility cuts of the multi-commodity flow model: integer
+	 * solutions are always separated (lazy), fractional ones at the root
+	 */
+	class FlowCutCallbackI : public IloCplex::LazyConstraintCallbackI
+	{
+		tcbvrp_ILP& ilp;
+	public:
+		FlowCutCallbackI( IloEnv env, tcbvrp_ILP& _ilp ) : IloCplex::LazyConstraintCallbackI( env ), ilp( _ilp ) {};
+		IloCplex::CallbackI* duplicateCallback() const { return new (getEnv()) FlowCutCallbackI( *this ); };
+		void main();
+	};
+
+	class FlowUserCutCallbackI : public IloCplex::UserCutCallbackI
+	{
+		tcbvrp_ILP& ilp;
+	public:
+		FlowUserCutCallbackI( IloEnv env, tcbvrp_ILP& _ilp ) : IloCplex::UserCutCallbackI( env ), ilp( _ilp ) {};
+		IloCplex::CallbackI* duplicateCallback() const { return new (getEnv()) FlowUserCutCallbackI( *this ); };
+		void main();
+	};
+
 	Instance& instance;
 	string model_type;
+	bool namedVars; // give every variable a name (costly for large models)
+	int heuristicThreads; // number of local search threads running next to CPLEX
+	bool quiet; // no CPLEX log and no result output, see getResult()
+	double timeLimit; // seconds
+	bool reducedCostFixing; // fix arcs by reduced costs of the root LP
+	bool pairGraphReduction; // only create arcs of the pair graph
+	int buildThreads; // more than one assembles the large constraint families in parallel
+
+	// arcs outside of the pair graph all share one variable fixed to 0
+	PairGraph* pairGraph;
+	IloBoolVar unusedArc;
+	bool hasArc(int j, int k) { return !pairGraph || pairGraph->hasArc(j, k); };
+	bool isUnusedArc(IloNumVar var) { return pairGraph && var.getId() == unusedArc.getId(); };
+
+	vector<VarBlock> varBlocks;
+	int tBlock; // block of the arc variables var_t
+
+	// all extracted variables, in the order used for injected solutions
+	IloNumVarArray startVars;
+	vector<pair<int, IloInt> > startCols; // block and column of each start variable
+
+	// periodic checkpoints of the best solution, CPLEX settings are kept next to it
+	Checkpoint* checkpoint;
+	bool resumeSettings;
+
+	// MIP start of the next solve, e.g. from a checkpoint
+	Solution startSolution;
+	bool hasStartSolution;
+
+	SolutionPool ownPool;
+	SolutionPool* pool; // shared with other solvers in a portfolio
+	ConcurrentHeuristic* heuristic;
+	bool ownsHeuristic;
+
+	// abort() may be called from other threads at any time
+	mutex abortLock;
+	bool abortRequested;
+	bool hasAborter;
+	IloCplex::Aborter aborter;
 
 	unsigned int n; // Number of Stations + Depot
 	unsigned int a; // Number of arcs
@@ -36,8 +132,56 @@ private:
 	IloModel model;
 	IloCplex cplex;
 
+	// rows and objective which are changed by the incremental interface
+	IloObjective objective;
+	vector<IloRange> coverRows;	// outgoing arcs of each demand node
+	IloRange supplyCountRow;	// number of visited supply nodes
+	vector<IloRange> timeRows;	// time limit of each tour
+
+	// time-flow model: conservation rows per tour and node (l*n + v) and the
+	// time window rows of every arc, all of them depend on the travel times
+	struct TimeFlowArc
+	{
+		int l, j, k;
+		IloNumVar x;
+		IloRange lower, upper;
+	};
+	vector<IloRange> timeFlowRows;
+	vector<TimeFlowArc> timeFlowArcs;
+
+	// columns fixed by reduced costs with their original upper bound
+	vector<pair<IloNumVar, IloNum> > fixedVars;
+
 	void initCPLEX();
 	void setCPLEXParameters();
+	void buildModel();
+	void optimize(double startTime);
+	void warmStart();
+	void initAborter();
+	void storeResult(double startTime);
+	int findVarBlock(string prefix, unsigned int numDims);
+	// permanent fixings are not undone by warmStart()
+	void fixToZero(IloNumVar var, bool permanent = false);
+	void fixByReducedCosts();
+	IloConversion addRelaxation();
+
+	int addVarBlock(string prefix, int d0, int d1 = -1, int d2 = -1, int d3 = -1);
+	void registerVar(int block, IloNumVar var, int i, int j = -1, int k = -1, int l = -1);
+	string decodeColumn(const VarBlock& block, IloInt col);
+
+	// column ids of the row assembler: block (high bits) and row-major position
+	// of the variable (low COLUMN_BITS bits)
+	static const int COLUMN_BITS = 40;
+	long encodeColumn(int block, int i, int j = -1, int k = -1, int l = -1);
+	IloNumVar columnVar(long id);
+	void addRows(long count, const RowAssembler::Family& family);
+	void printSolution();
+	void printResourceUsage(string phase);
+
+	void decodeIndices(const VarBlock& block, IloInt col, int idx[4]);
+	void initStartVars();
+	Solution valuesToSolution(const IloNumArray& tValues);
+	IloNumArray solutionToValues(const Solution& sol);
 
 	void initConstraints(BoolVar3Matrix var_t,IloBoolVarArray var_r);
 	void initDecisionVars(BoolVar3Matrix &var_t, IloBoolVarArray &var_r);
@@ -45,12 +189,88 @@ private:
 	void modelSCF();
 	void modelMCF();
 	void modelMTZ();
+	void modelMCFBenders();
+	void modelTimeFlow();
+	void timeWindows(vector<double>& earliest, vector<double>& remaining);
+	void updateTimeFlowBounds();
+	void separateFlowCuts(IloEnv cbEnv, const IloNumArray& tValues, IloNum minViolation, vector<IloRange>& cuts);
 
 public:
 
-	tcbvrp_ILP( Instance& _instance, string _model_type);
+	// outcome of the last call of solve()
+	struct Result
+	{
+		IloAlgorithm::Status status;
+		IloInt nodes;
+		IloNum objValue;	// only valid if hasSolution
+		IloNum bound;
+		double time;		// wall clock seconds spent in solve()
+		bool hasSolution;
+		Solution solution;
+	};
+
+	// model size and bounds of the root node, see solveRoot()
+	struct RootResult
+	{
+		IloInt rows, cols, nonzeros;
+		double buildTime, lpTime, rootTime;	// wall clock seconds
+		IloAlgorithm::Status lpStatus;
+		IloNum lpBound;		// only valid if lpStatus is Optimal
+		IloNum rootBound;	// only valid if hasRootBound
+		bool hasRootBound;
+
+		RootResult() : rows( 0 ), cols( 0 ), nonzeros( 0 ), buildTime( 0 ), lpTime( 0 ), rootTime( 0 ),
+			lpStatus( IloAlgorithm::Unknown ), lpBound( 0 ), rootBound( 0 ), hasRootBound( false ) {};
+	};
+
+	tcbvrp_ILP( Instance& _instance, string _model_type, bool _namedVars = true);
 	~tcbvrp_ILP();
-	void solve();
+	void setHeuristicThreads(int threads) { heuristicThreads = threads; };
+	void setQuiet(bool _quiet) { quiet = _quiet; };
+	void setTimeLimit(double seconds) { timeLimit = seconds; };
+	void setReducedCostFixing(bool enable) { reducedCostFixing = enable; };
+
+	// build the formulations on the pair graph, which assumes the instance
+	// does not change any more (no incremental changes afterwards)
+	void setPairGraphReduction(bool enable) { pairGraphReduction = enable; };
+	void setBuildThreads(int threads) { buildThreads = threads; };
+
+	// writes the best solution to the checkpoint during and after solving, with
+	// resume the CPLEX settings saved next to the checkpoint are read back
+	void setCheckpoint(Checkpoint* _checkpoint, bool resume = false) { checkpoint = _checkpoint; resumeSettings = resume; };
+	void setStartSolution(const Solution& sol) { startSolution = sol; hasStartSolution = true; };
+
+	// exchange incumbents with other solvers through a common pool (and workers)
+	void shareSolutions(SolutionPool* _pool, ConcurrentHeuristic* _heuristic);
+
+	// returns false if CPLEX raised an exception
+	bool solve();
+
+	/*
+	 * incremental changes of a solved model, they are applied to the instance
+	 * and to the live model; resolve() starts from the previous basis and the
+	 * previous solution repaired for the changed instance
+	 */
+	void setNodeCoverage(int node, bool required);
+	void setArcTime(int i, int j, double time);
+	void setRouteTimeLimit(int limit);
+	bool resolve();
+
+	// builds the model and only solves its LP relaxation and, with cuts, the
+	// root node; returns false if CPLEX raised an exception
+	bool solveRoot(bool withCuts);
+	const RootResult& getRootResult() { return rootResult; };
+
+	// stops a running solve() as soon as possible, thread-safe
+	void abort();
+
+	const Result& getResult() { return result; };
+	string getModelType() { return model_type; };
+
+private:
+
+	Result result;
+	RootResult rootResult;
 
 };
 